@@ -0,0 +1,441 @@
+/**
+ * @file bench.cpp
+ * @brief microbenchmarks for the storage policies and the graph algorithms
+ *
+ * usage: ./bench.exe [nodes] [sparse nodes] [closure nodes] [shortest paths nodes] [all pairs nodes] [snapshot nodes] [edge list nodes] [export nodes] [large all pairs nodes]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ograph.hpp"
+
+struct equal_int {
+  bool operator()(int a, int b) const {
+    return a == b;
+  }
+};
+
+struct hash_int {
+  std::size_t operator()(int a) const {
+    return static_cast<std::size_t>(a);
+  }
+};
+
+/**
+ * @brief time a kernel, taking the best of a few runs
+ *
+ * @return the duration of the fastest run, in seconds
+ */
+template <typename F>
+double best_of(F run){
+  double best = 1e30;
+  for(int r=0; r<5; r++){
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    run();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
+
+void report(const char* name, const char* kernels, double seconds, std::size_t bytes, std::size_t result){
+  std::cout << name << " [" << kernels << "]: " << seconds*1000 << " ms, "
+    << bytes / seconds / 1e9 << " GB/s (result " << result << ")" << std::endl;
+}
+
+/**
+ * @brief run the matrix scans with the given kernels
+ *
+ * The layouts are the same of dense_storage and bit_storage:
+ * rows of stride cells, every row on its own cache line.
+ */
+void bench_with(const simd_kernels &simd, std::size_t n,
+    const int* cells, std::size_t cell_stride, const std::uint64_t* words, std::size_t word_stride){
+  volatile std::size_t sink = 0;
+  std::size_t result = 0;
+  std::vector<unsigned int> out(n), in(n);
+
+  double t = best_of([&]{ result = simd.sum(cells, n * cell_stride); });
+  report("dense count  ", simd.name, t, n * cell_stride * sizeof(int), result);
+
+  t = best_of([&]{
+    std::fill(in.begin(), in.end(), 0);
+    for(std::size_t i=0; i<n; i++){
+      out[i] = static_cast<unsigned int>(simd.sum(cells + i*cell_stride, n));
+      simd.accumulate(in.data(), cells + i*cell_stride, n);
+    }
+  });
+  report("dense degrees", simd.name, t, n * cell_stride * sizeof(int), in[n/2] + out[n/2]);
+
+  t = best_of([&]{ result = simd.popcount(words, n * word_stride); });
+  report("bit count    ", simd.name, t, n * word_stride * sizeof(std::uint64_t), result);
+  sink = sink + result;
+}
+
+/**
+ * @brief run the parallel breadth first visit on a random sparse graph
+ *
+ * @param n the amount of nodes
+ * @param degree the out degree of every node
+ */
+void bench_parallel_bfs(int n, int degree){
+  std::vector<int> nodes(n);
+  std::vector<std::pair<int, int> > edges;
+  unsigned int seed = 7;
+  for(int i=0; i<n; i++){
+    nodes[i] = i;
+    for(int d=0; d<degree; d++){
+      seed = seed * 1103515245u + 12345u;
+      edges.push_back(std::make_pair(i, static_cast<int>((seed >> 4) % n)));
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+  og.freeze();
+
+  std::cout << n << " nodes, " << og.edges() << " edges, parallel bfs" << std::endl;
+  std::size_t serial = 0;
+  const double t = best_of([&]{
+    serial = 0;
+    og.bfs(0, [&](const int &){ serial++; });
+  });
+  std::cout << "serial bfs: " << t*1000 << " ms (reached " << serial << ")" << std::endl;
+
+  const unsigned cores = parallel_threads(0);
+  for(unsigned threads=1; threads<=cores; threads*=2){
+    std::size_t reached = 0;
+    const double t = best_of([&]{
+      reached = 0;
+      og.parallelBfs(0, [&](const int &, unsigned int){ reached++; }, threads);
+    });
+    std::cout << "parallel bfs [" << threads << " threads]: " << t*1000 << " ms (reached " << reached << ")" << std::endl;
+  }
+}
+
+/**
+ * @brief compute the transitive closure of a random graph with a giant component
+ *
+ * @param n the amount of nodes
+ */
+void bench_transitive_closure(int n){
+  std::vector<int> nodes(n);
+  std::vector<std::pair<int, int> > edges;
+  unsigned int seed = 11;
+  for(int i=0; i<n; i++){
+    nodes[i] = i;
+    for(int d=0; d<2; d++){
+      seed = seed * 1103515245u + 12345u;
+      edges.push_back(std::make_pair(i, static_cast<int>((seed >> 4) % n)));
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  oriented_graph<int, equal_int, hash_int, bit_storage> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+
+  std::cout << n << " nodes, " << og.edges() << " edges, transitive closure" << std::endl;
+  const unsigned cores = parallel_threads(0);
+  for(unsigned threads=1; threads<=cores; threads*=2){
+    int closure_edges = 0;
+    const double t = best_of([&]{ closure_edges = og.transitiveClosure(threads).edges(); });
+    std::cout << "transitive closure [" << threads << " threads]: " << t*1000 << " ms (" << closure_edges << " edges)" << std::endl;
+  }
+}
+
+/**
+ * @brief repeated single source shortest paths on a random sparse graph
+ *
+ * @param n the amount of nodes
+ * @param degree the out degree of every node
+ */
+void bench_shortest_paths(int n, int degree){
+  std::vector<int> nodes(n);
+  for(int i=0; i<n; i++)
+    nodes[i] = i;
+  oriented_graph<int, equal_int, hash_int, sparse_storage<int> > weighted, unit;
+  weighted.addNodes(nodes.begin(), nodes.end());
+  unit.addNodes(nodes.begin(), nodes.end());
+  unsigned int seed = 13;
+  for(int i=0; i<n; i++)
+    for(int d=0; d<degree; d++){
+      seed = seed * 1103515245u + 12345u;
+      const int j = static_cast<int>((seed >> 4) % n);
+      if(!weighted.existsEdge(i, j)){
+        weighted.addEdge(i, j, 1 + static_cast<int>(seed >> 24));
+        unit.addEdge(i, j);
+      }
+    }
+  weighted.freeze();
+  unit.freeze();
+
+  std::cout << n << " nodes, " << weighted.edges() << " edges, shortest paths" << std::endl;
+  oriented_graph<int, equal_int, hash_int, sparse_storage<int> >::shortest_paths paths;
+  int source = 0;
+  double t = best_of([&]{ unit.shortestPaths(source++ % n, paths); });
+  std::cout << "shortest paths [unit weights, bfs]: " << t*1000 << " ms" << std::endl;
+  t = best_of([&]{ weighted.shortestPaths(source++ % n, paths); });
+  std::cout << "shortest paths [integer weights, radix heap]: " << t*1000 << " ms" << std::endl;
+}
+
+/**
+ * @brief all pairs shortest paths, against the textbook Floyd-Warshall
+ *
+ * The textbook version runs the three loops over the whole matrix,
+ * one pivot at a time. It is cubic and takes minutes above a few
+ * thousand nodes, so larger graphs check some rows of the matrix
+ * against shortestPaths instead.
+ *
+ * @param n the amount of nodes
+ * @param textbook_limit the largest n that runs the textbook version
+ */
+void bench_all_pairs(int n, int textbook_limit){
+  std::vector<int> nodes(n);
+  for(int i=0; i<n; i++)
+    nodes[i] = i;
+  oriented_graph<int, equal_int, hash_int, sparse_storage<int> > og;
+  og.addNodes(nodes.begin(), nodes.end());
+  unsigned int seed = 17;
+  for(int i=0; i<n; i++)
+    for(int d=0; d<4; d++){
+      seed = seed * 1103515245u + 12345u;
+      const int j = static_cast<int>((seed >> 4) % n);
+      if(!og.existsEdge(i, j))
+        og.addEdge(i, j, 1 + static_cast<int>(seed >> 24));
+    }
+  std::cout << n << " nodes, " << og.edges() << " edges, all pairs shortest paths" << std::endl;
+
+  const bool textbook = n <= textbook_limit;
+  const int infinity = 0x3fffffff;
+  std::vector<int> naive;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if(textbook){
+    naive.assign(static_cast<std::size_t>(n) * n, infinity);
+    //the labels are the positions of the nodes
+    for(oriented_graph<int, equal_int, hash_int, sparse_storage<int> >::edge_iterator e = og.edge_begin(); e != og.edge_end(); e++)
+      naive[static_cast<std::size_t>(e.from()) * n + e.to()] = og.weight(e.from(), e.to());
+    for(int i=0; i<n; i++)
+      naive[static_cast<std::size_t>(i) * n + i] = 0;
+    for(int k=0; k<n; k++)
+      for(int i=0; i<n; i++){
+        const int through = naive[static_cast<std::size_t>(i) * n + k];
+        for(int j=0; j<n; j++)
+          naive[static_cast<std::size_t>(i) * n + j] = std::min(naive[static_cast<std::size_t>(i) * n + j], through + naive[static_cast<std::size_t>(k) * n + j]);
+      }
+    const std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+    std::cout << "textbook floyd-warshall: " << t.count()*1000 << " ms" << std::endl;
+  }
+  else
+    std::cout << "textbook floyd-warshall: skipped above " << textbook_limit << " nodes, 16 rows checked with shortestPaths" << std::endl;
+
+  const unsigned cores = parallel_threads(0);
+  oriented_graph<int, equal_int, hash_int, sparse_storage<int> >::shortest_paths paths;
+  for(unsigned threads=1; threads<=cores; threads*=2){
+    start = std::chrono::steady_clock::now();
+    const oriented_graph<int, equal_int, hash_int, sparse_storage<int> >::distance_matrix all = og.allPairsShortestPaths(threads);
+    const std::chrono::duration<double> blocked = std::chrono::steady_clock::now() - start;
+    std::size_t mismatches = 0;
+    if(textbook)
+      for(int i=0; i<n; i++)
+        for(int j=0; j<n; j++){
+          const int expected = naive[static_cast<std::size_t>(i) * n + j];
+          mismatches += expected >= infinity ? all(i, j) != all.unreached : all(i, j) != expected;
+        }
+    else
+      for(int s=0; s<16; s++){
+        const int i = static_cast<int>(static_cast<long long>(s) * n / 16);
+        og.shortestPaths(i, paths);
+        for(int j=0; j<n; j++)
+          mismatches += paths.reached(j) ? all(i, j) != paths.distances()[j] : all(i, j) != all.unreached;
+      }
+    std::cout << "blocked floyd-warshall [" << threads << " threads, " << simd_dispatch().name << "]: "
+      << blocked.count()*1000 << " ms (" << mismatches << " mismatches)" << std::endl;
+  }
+}
+
+/**
+ * @brief load a graph from a snapshot, against building it with addNode and addEdge
+ *
+ * @param n the amount of nodes
+ */
+void bench_snapshot(int n){
+  typedef oriented_graph<int, equal_int, hash_int, dense_storage<> > graph;
+  const char* path = "/tmp/ograph_bench_snapshot.bin";
+  std::vector<std::pair<int, int> > edges;
+  unsigned int seed = 19;
+  for(int i=0; i<n; i++)
+    for(int d=0; d<8; d++){
+      seed = seed * 1103515245u + 12345u;
+      edges.push_back(std::make_pair(i, static_cast<int>((seed >> 4) % n)));
+    }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  graph og;
+  for(int i=0; i<n; i++)
+    og.addNode(i);
+  for(std::size_t e=0; e<edges.size(); e++)
+    og.addEdge(edges[e].first, edges[e].second);
+  const std::chrono::duration<double> built = std::chrono::steady_clock::now() - start;
+  std::cout << n << " nodes, " << og.edges() << " edges, snapshot" << std::endl;
+  std::cout << "build with addNode and addEdge: " << built.count()*1000 << " ms" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  og.save(path);
+  const std::chrono::duration<double> saved = std::chrono::steady_clock::now() - start;
+  std::cout << "save: " << saved.count()*1000 << " ms" << std::endl;
+
+  for(int map=1; map>=0; map--){
+    start = std::chrono::steady_clock::now();
+    const graph loaded = graph::load(path, map == 1);
+    const std::chrono::duration<double> load = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    std::size_t found = 0;
+    for(std::size_t e=0; e<edges.size(); e+=97)
+      found += loaded.existsEdge(edges[e].first, edges[e].second);
+    const std::chrono::duration<double> query = std::chrono::steady_clock::now() - start;
+    std::cout << "load [" << (map ? "mapped" : "read") << "]: " << load.count()*1000 << " ms, then "
+      << found << " edge queries: " << query.count()*1000 << " ms" << std::endl;
+  }
+  std::remove(path);
+}
+
+/**
+ * @brief read a text edge list, against parsing it with operator>> and addEdge
+ *
+ * @param n the amount of nodes
+ */
+void bench_edge_list(int n){
+  typedef oriented_graph<int, equal_int, hash_int, sparse_storage<> > graph;
+  std::vector<std::pair<int, int> > edges;
+  unsigned int seed = 23;
+  for(int i=0; i<n; i++)
+    for(int d=0; d<8; d++){
+      seed = seed * 1103515245u + 12345u;
+      edges.push_back(std::make_pair(i, static_cast<int>((seed >> 4) % n)));
+    }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  std::string text;
+  for(std::size_t e=0; e<edges.size(); e++)
+    text += std::to_string(edges[e].first) + " " + std::to_string(edges[e].second) + "\n";
+  std::cout << n << " nodes, " << edges.size() << " edges, " << text.size() / 1e6 << " MB edge list" << std::endl;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::istringstream naive_in(text);
+  graph naive;
+  int from, to;
+  while(naive_in >> from >> to){
+    if(!naive.existsNode(from))
+      naive.addNode(from);
+    if(!naive.existsNode(to))
+      naive.addNode(to);
+    naive.addEdge(from, to);
+  }
+  const std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+  std::cout << "operator>> and addEdge: " << t.count()*1000 << " ms, " << text.size() / t.count() / 1e6 << " MB/s" << std::endl;
+
+  const unsigned cores = parallel_threads(0);
+  for(unsigned threads=1; threads<=cores; threads*=2){
+    std::size_t loaded = 0;
+    const double t = best_of([&]{
+      std::istringstream in(text);
+      loaded = graph::readEdgeList(in, threads).edges();
+    });
+    std::cout << "readEdgeList [" << threads << " threads]: " << t*1000 << " ms, "
+      << text.size() / t / 1e6 << " MB/s (" << loaded << " edges)" << std::endl;
+  }
+}
+
+/**
+ * @brief export a sparse graph, against the cell by cell output of the old print
+ *
+ * @param n the amount of nodes
+ */
+void bench_export(int n){
+  typedef oriented_graph<int, equal_int, hash_int, sparse_storage<int> > graph;
+  std::vector<int> nodes(n);
+  for(int i=0; i<n; i++)
+    nodes[i] = i;
+  graph og;
+  og.addNodes(nodes.begin(), nodes.end());
+  unsigned int seed = 29;
+  for(int i=0; i<n; i++)
+    for(int d=0; d<4; d++){
+      seed = seed * 1103515245u + 12345u;
+      const int j = static_cast<int>((seed >> 4) % n);
+      if(!og.existsEdge(i, j))
+        og.addEdge(i, j, 1 + static_cast<int>(seed >> 24));
+    }
+  std::cout << n << " nodes, " << og.edges() << " edges, export to /dev/null" << std::endl;
+  std::ofstream null("/dev/null");
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(int i=0; i<n; i++){
+    for(int j=0; j<n; j++)
+      null << og.existsEdge(i, j) << " ";
+    null << std::endl;
+  }
+  std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+  std::cout << "old print, cell by cell: " << t.count()*1000 << " ms" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  og.writeMatrix(null);
+  t = std::chrono::steady_clock::now() - start;
+  std::cout << "writeMatrix: " << t.count()*1000 << " ms" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  og.writeEdgeList(null);
+  t = std::chrono::steady_clock::now() - start;
+  std::cout << "writeEdgeList: " << t.count()*1000 << " ms" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  og.writeDot(null);
+  t = std::chrono::steady_clock::now() - start;
+  std::cout << "writeDot: " << t.count()*1000 << " ms" << std::endl;
+}
+
+int main(int argc, char** argv){
+  const std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8192;
+  const int sparse_n = argc > 2 ? std::atoi(argv[2]) : 100000;
+  const std::size_t cell_stride = storage_stride_for<int>(n);
+  const std::size_t word_stride = storage_stride_for<std::uint64_t>((n + 63) / 64);
+
+  int* cells = storage_new_cells<int>(n * cell_stride);
+  std::uint64_t* words = storage_new_cells<std::uint64_t>(n * word_stride);
+  unsigned int seed = 1;
+  for(std::size_t i=0; i<n; i++)
+    for(std::size_t j=0; j<n; j++){
+      seed = seed * 1103515245u + 12345u;
+      if((seed >> 16) % 8 == 0){
+        cells[i*cell_stride + j] = 1;
+        words[i*word_stride + j/64] |= std::uint64_t(1) << (j%64);
+      }
+    }
+
+  std::cout << n << " nodes, dispatched kernels: " << simd_dispatch().name << std::endl;
+  bench_with(simd_scalar(), n, cells, cell_stride, words, word_stride);
+  bench_with(simd_dispatch(), n, cells, cell_stride, words, word_stride);
+
+  storage_delete_cells(cells);
+  storage_delete_cells(words);
+
+  bench_parallel_bfs(sparse_n, 16);
+  bench_transitive_closure(argc > 3 ? std::atoi(argv[3]) : 4096);
+  bench_shortest_paths(argc > 4 ? std::atoi(argv[4]) : 50000, 4);
+  bench_all_pairs(argc > 5 ? std::atoi(argv[5]) : 1024, 4096);
+  bench_all_pairs(argc > 9 ? std::atoi(argv[9]) : 8192, 4096);
+  bench_snapshot(argc > 6 ? std::atoi(argv[6]) : 16384);
+  bench_edge_list(argc > 7 ? std::atoi(argv[7]) : 1000000);
+  bench_export(argc > 8 ? std::atoi(argv[8]) : 20000);
+  return 0;
+}
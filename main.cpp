@@ -5,6 +5,17 @@
 
 #include <iostream>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "ograph.hpp"
 #include "animal.hpp"
 #include "testframework.hpp"
@@ -38,6 +49,33 @@ struct equal_animal {
   }
 };
 
+/**
+ * @brief functor for integer hashing
+ */
+struct hash_int {
+  std::size_t operator()(int a) const {
+    return static_cast<std::size_t>(a);
+  }
+};
+
+/**
+ * @brief functor for integer hashing, where every value collides
+ */
+struct collide_int {
+  std::size_t operator()(int) const {
+    return 42;
+  }
+};
+
+/**
+ * @brief functor for custom class animal hashing, consistent with equal_animal
+ */
+struct hash_animal {
+  std::size_t operator()(const animal &a) const {
+    return static_cast<std::size_t>(a.getLegs()*2 + a.doesQuack());
+  }
+};
+
 void test_custom_class(){
   std::cout << "====== TEST_CUSTOM_CLASS ======" << std::endl;
 
@@ -576,6 +614,2539 @@ void test_iterator(){
   assert(sum == 3);
 }
 
+template <typename H>
+void test_hash_index_with(){
+  oriented_graph<int, equal_int, H> og;
+
+  //enough nodes to force several rehashes
+  for(int i=0; i<300; i++)
+    og.addNode(i*7);
+  assert(og.nodes() == 300);
+  for(int i=0; i<300; i++)
+    assert(og.existsNode(i*7));
+  assert(!og.existsNode(1));
+  assert(!og.existsNode(300*7));
+  M_ASSERT_THROW(
+      og.addNode(14),
+      invalidNodeException
+      );
+
+  og.addEdge(0, 7);
+  og.addEdge(7, 14);
+  og.addEdge(14, 0);
+  assert(og.edges() == 3);
+
+  //removal shifts the positions of the other nodes
+  og.removeNode(7);
+  assert(!og.existsNode(7));
+  assert(og.nodes() == 299);
+  assert(og.edges() == 1);
+  assert(og.existsEdge(14, 0));
+  assert(!og.existsEdge(0, 7));
+  for(int i=2; i<300; i++)
+    assert(og.existsNode(i*7));
+  og.addNode(7);
+  assert(og.existsNode(7));
+  assert(!og.existsEdge(0, 7));
+
+  //copy construction
+  oriented_graph<int, equal_int, H> og2(og);
+  og.removeNode(0);
+  assert(!og.existsNode(0));
+  assert(og2.existsNode(0));
+  assert(og2.existsEdge(14, 0));
+  assert(og2.nodes() == 300);
+
+  //swap
+  oriented_graph<int, equal_int, H> og3;
+  og3.addNode(-1);
+  og3.swap(og2);
+  assert(og3.existsNode(0));
+  assert(og3.existsEdge(14, 0));
+  assert(!og3.existsNode(-1));
+  assert(og2.existsNode(-1));
+  assert(!og2.existsNode(0));
+
+  //removal of everything
+  for(int i=0; i<300; i++)
+    og3.removeNode(i*7);
+  assert(og3.nodes() == 0);
+  assert(!og3.existsNode(14));
+  og3.addNode(14);
+  assert(og3.existsNode(14));
+}
+
+void test_hash_index(){
+  std::cout << "====== TEST_HASH_INDEX ======" << std::endl;
+
+  test_hash_index_with<hash_int>();
+  test_hash_index_with<collide_int>();
+
+  //custom class, with duck typing
+  animal duck1 = animal(true, 2);
+  animal duck2 = animal(true, 2);
+  animal dog1 = animal(false, 2);
+  animal list[] = {duck1, dog1};
+  oriented_graph<animal, equal_animal, hash_animal> og(list, 2);
+  assert(og.existsNode(duck2));
+  og.addEdge(duck2, dog1);
+  assert(og.existsEdge(duck1, dog1));
+  M_ASSERT_THROW(
+      og.addNode(duck2),
+      invalidNodeException
+      );
+
+  animal invalid_animals[] = {duck1, dog1, duck2};
+  M_ASSERT_THROW(
+    (oriented_graph<animal, equal_animal, hash_animal>(invalid_animals, 3)),
+    invalidNodeException
+  );
+}
+
+void test_capacity(){
+  std::cout << "====== TEST_CAPACITY ======" << std::endl;
+
+  oriented_graph<int, equal_int, hash_int> og;
+  assert(og.capacity() == 0);
+
+  //geometric growth
+  for(int i=0; i<1000; i++)
+    og.addNode(i);
+  assert(og.nodes() == 1000);
+  assert(og.capacity() >= 1000);
+  assert(og.capacity() < 2000);
+  for(int i=0; i<999; i++)
+    og.addEdge(i, i+1);
+  assert(og.edges() == 999);
+
+  //growth keeps the edges
+  og.reserve(5000);
+  assert(og.capacity() == 5000);
+  assert(og.nodes() == 1000);
+  assert(og.edges() == 999);
+  assert(og.existsEdge(500, 501));
+  assert(!og.existsEdge(501, 500));
+
+  //a smaller reserve is a no-op
+  og.reserve(10);
+  assert(og.capacity() == 5000);
+
+  //removal keeps the capacity, and the cells of the removed node are cleared
+  og.removeNode(999);
+  assert(og.capacity() == 5000);
+  assert(og.edges() == 998);
+  og.addNode(999);
+  assert(!og.existsEdge(998, 999));
+  assert(og.edges() == 998);
+
+  og.shrink_to_fit();
+  assert(og.capacity() == 1000);
+  assert(og.edges() == 998);
+  assert(og.existsEdge(0, 1));
+  assert(og.existsNode(999));
+
+  //empty graph
+  oriented_graph<char, equal_char> og1;
+  og1.reserve(3);
+  assert(og1.capacity() == 3);
+  assert(og1.nodes() == 0);
+  assert(og1.edges() == 0);
+  og1.addNode('a');
+  og1.addNode('b');
+  og1.addEdge('a', 'b');
+  og1.removeNode('a');
+  og1.removeNode('b');
+  og1.shrink_to_fit();
+  assert(og1.capacity() == 0);
+  assert(og1.begin() == og1.end());
+  og1.addNode('a');
+  og1.addNode('b');
+  assert(og1.edges() == 0);
+
+  //copies are allocated for the actual size
+  oriented_graph<int, equal_int, hash_int> og2(og);
+  og.reserve(6000);
+  assert(og2.capacity() == 1000);
+  assert(og2.edges() == 998);
+  assert(og2.existsEdge(0, 1));
+}
+
+
+void test_matrix_layout(){
+  std::cout << "====== TEST_MATRIX_LAYOUT ======" << std::endl;
+
+  //a graph larger than a cache line of cells, with the edges i -> i+1 and i -> i
+  oriented_graph<int, equal_int> og;
+  for(int i=0; i<40; i++)
+    og.addNode(i);
+  for(int i=0; i<40; i++){
+    og.addEdge(i, i);
+    if(i+1 < 40)
+      og.addEdge(i, i+1);
+  }
+  assert(og.edges() == 79);
+
+  //remove nodes from the start, the middle and the end of the matrix
+  og.removeNode(0);
+  og.removeNode(17);
+  og.removeNode(39);
+  assert(og.nodes() == 37);
+  assert(og.edges() == 37 + 35);
+  for(int i=1; i<39; i++){
+    if(i == 17)
+      continue;
+    assert(og.existsEdge(i, i));
+    assert(og.existsEdge(i, i+1) == (i != 16 && i != 38));
+    assert(!og.existsEdge(i+1, i));
+  }
+
+  //grow across the stride boundary, the new cells are empty
+  for(int i=100; i<140; i++)
+    og.addNode(i);
+  assert(og.edges() == 37 + 35);
+  assert(!og.existsEdge(38, 100));
+  assert(!og.existsEdge(100, 100));
+}
+
+/**
+ * @brief deterministic edge pattern used by the storage tests
+ */
+bool pattern_edge(int from, int to){
+  return (from*7 + to*13) % 5 == 0 || from == to;
+}
+
+template <typename S>
+void test_storage_policy_with(){
+  const int n = 150;
+  oriented_graph<int, equal_int, hash_int, S> og;
+  int count = 0;
+  for(int i=0; i<n; i++)
+    og.addNode(i);
+  for(int i=0; i<n; i++)
+    for(int j=0; j<n; j++)
+      if(pattern_edge(i, j)){
+        og.addEdge(i, j);
+        count++;
+      }
+  assert(og.edges() == count);
+
+  //remove nodes on the word boundaries of the bit storage
+  const int removed[] = {0, 63, 64, 127, 149, 100};
+  for(int r : removed){
+    for(int j=0; j<n; j++){
+      if(og.existsNode(j) && pattern_edge(r, j))
+        count--;
+      if(og.existsNode(j) && j != r && pattern_edge(j, r))
+        count--;
+    }
+    og.removeNode(r);
+  }
+  assert(og.nodes() == n - 6);
+  assert(og.edges() == count);
+  for(int i=0; i<n; i++)
+    for(int j=0; j<n; j++)
+      assert(og.existsEdge(i, j) == (og.existsNode(i) && og.existsNode(j) && pattern_edge(i, j)));
+
+  //copies and growth keep the edges
+  oriented_graph<int, equal_int, hash_int, S> og2(og);
+  og2.reserve(1000);
+  og2.removeEdge(1, 1);
+  assert(og2.edges() == count - 1);
+  assert(og.edges() == count);
+  for(int i=0; i<n; i++)
+    for(int j=0; j<n; j++)
+      if(i != 1 || j != 1)
+        assert(og2.existsEdge(i, j) == og.existsEdge(i, j));
+
+  //the cells of the removed nodes are clear when the positions are reused
+  og.addNode(1000);
+  og.addNode(1001);
+  assert(og.edges() == count);
+  assert(!og.existsEdge(1000, 1000));
+  assert(!og.existsEdge(1001, 1000));
+}
+
+void test_storage_policy(){
+  std::cout << "====== TEST_STORAGE_POLICY ======" << std::endl;
+
+  test_storage_policy_with<dense_storage<> >();
+  test_storage_policy_with<bit_storage>();
+  test_storage_policy_with<sparse_storage<> >();
+
+  //same api on custom classes
+  animal duck1 = animal(true, 2);
+  animal dog1 = animal(false, 4);
+  oriented_graph<animal, equal_animal, no_hash, bit_storage> og;
+  og.addNode(duck1);
+  og.addNode(dog1);
+  og.addEdge(dog1, duck1);
+  assert(og.existsEdge(dog1, duck1));
+  assert(!og.existsEdge(duck1, dog1));
+  assert(og.edges() == 1);
+  og.print();
+  og.removeNode(duck1);
+  assert(og.edges() == 0);
+}
+
+template <typename S>
+void test_frozen_storage_with(){
+  const int n = 80;
+  oriented_graph<int, equal_int, hash_int, S> og;
+  int count = 0;
+  for(int i=0; i<n; i++)
+    og.addNode(i);
+  for(int i=0; i<n; i++)
+    for(int j=0; j<n; j++)
+      if(pattern_edge(i, j)){
+        og.addEdge(i, j);
+        count++;
+      }
+
+  //reads on the frozen form
+  og.freeze();
+  og.freeze();
+  assert(og.edges() == count);
+  for(int i=0; i<n; i++)
+    for(int j=0; j<n; j++)
+      assert(og.existsEdge(i, j) == pattern_edge(i, j));
+
+  //edge removal and node removal work in place on the frozen form
+  og.removeEdge(5, 5);
+  count--;
+  for(int j=0; j<n; j++){
+    if(pattern_edge(10, j))
+      count--;
+    if(j != 10 && pattern_edge(j, 10))
+      count--;
+  }
+  og.removeNode(10);
+  assert(og.edges() == count);
+
+  //copies of frozen graphs, and new nodes past the frozen rows
+  oriented_graph<int, equal_int, hash_int, S> og2(og);
+  og2.addNode(n);
+  assert(!og2.existsEdge(n, n));
+  assert(og2.edges() == count);
+
+  //insertion thaws the lists
+  og.addNode(n);
+  og.addEdge(n, 0);
+  og.addEdge(5, 5);
+  count += 2;
+  assert(og.edges() == count);
+  for(int i=0; i<=n; i++)
+    for(int j=0; j<=n; j++){
+      bool expected = i != 10 && j != 10 && i < n && j < n && pattern_edge(i, j);
+      if(i == n && j == 0)
+        expected = true;
+      assert(og.existsEdge(i, j) == expected);
+      if(!(i == n && j == 0) && !(i == 5 && j == 5))
+        assert(og2.existsEdge(i, j) == expected);
+    }
+  assert(!og2.existsEdge(5, 5));
+}
+
+void test_sparse_storage(){
+  std::cout << "====== TEST_SPARSE_STORAGE ======" << std::endl;
+
+  test_frozen_storage_with<sparse_storage<> >();
+  //freeze is a no-op on the matrix storages
+  test_frozen_storage_with<bit_storage>();
+
+  //growth of a frozen graph keeps the CSR block
+  oriented_graph<char, equal_char, no_hash, sparse_storage<> > og;
+  og.addNode('a');
+  og.addNode('b');
+  og.addEdge('a', 'b');
+  og.freeze();
+  og.reserve(100);
+  og.addNode('c');
+  assert(og.existsEdge('a', 'b'));
+  assert(og.edges() == 1);
+  og.removeNode('a');
+  assert(og.edges() == 0);
+  og.addEdge('c', 'b');
+  assert(og.existsEdge('c', 'b'));
+  og.print();
+
+  //a frozen graph moved or copied to a smaller capacity after a removal
+  typedef oriented_graph<int, equal_int, no_hash, sparse_storage<> > graph;
+  graph shrunk;
+  for(int i=0; i<5; i++)
+    shrunk.addNode(i);
+  shrunk.addEdge(0, 1);
+  shrunk.freeze();
+  shrunk.removeNode(4);
+  graph copied(shrunk);
+  shrunk.shrink_to_fit();
+  shrunk.addEdge(1, 2);
+  copied.addEdge(1, 2);
+  assert(shrunk.existsEdge(0, 1) && shrunk.existsEdge(1, 2) && shrunk.edges() == 2);
+  assert(copied.existsEdge(0, 1) && copied.existsEdge(1, 2) && copied.edges() == 2);
+}
+
+template <typename S>
+void test_bulk_constructor_with(){
+  typedef oriented_graph<int, equal_int, hash_int, S> graph;
+
+  //node and edge arrays
+  int nodes[] = {0, 1, 2, 3, 4};
+  std::pair<int, int> edges[] = {{0, 1}, {1, 2}, {2, 0}, {4, 4}};
+  graph og(nodes, nodes+5, edges, edges+4);
+  assert(og.nodes() == 5);
+  assert(og.edges() == 4);
+  assert(og.existsEdge(0, 1));
+  assert(og.existsEdge(2, 0));
+  assert(og.existsEdge(4, 4));
+  assert(!og.existsEdge(1, 0));
+  assert(!og.existsEdge(3, 3));
+
+  //the graph can be modified after the bulk construction
+  og.addEdge(1, 0);
+  og.removeNode(2);
+  assert(og.edges() == 3);
+  assert(og.existsEdge(1, 0));
+  og.addNode(2);
+  assert(!og.existsEdge(2, 0));
+
+  //empty ranges
+  graph og1(nodes, nodes, edges, edges);
+  assert(og1.nodes() == 0);
+  assert(og1.edges() == 0);
+  graph og2(nodes, nodes+5, edges, edges);
+  assert(og2.nodes() == 5);
+  assert(og2.edges() == 0);
+
+  //invalid input
+  int dup_nodes[] = {0, 1, 2, 1};
+  M_ASSERT_THROW(
+      graph(dup_nodes, dup_nodes+4, edges, edges),
+      invalidNodeException
+      );
+  std::pair<int, int> unknown_edges[] = {{0, 1}, {1, 9}};
+  M_ASSERT_THROW(
+      graph(nodes, nodes+5, unknown_edges, unknown_edges+2),
+      invalidNodeException
+      );
+  std::pair<int, int> dup_edges[] = {{0, 1}, {3, 4}, {0, 1}};
+  M_ASSERT_THROW(
+      graph(nodes, nodes+5, dup_edges, dup_edges+3),
+      invalidEdgeException
+      );
+
+  //large graphs from containers
+  std::vector<int> many_nodes;
+  std::vector<std::pair<int, int> > many_edges;
+  const int n = 20000;
+  for(int i=0; i<n; i++){
+    many_nodes.push_back(i);
+    many_edges.push_back(std::make_pair(i, (i*31+7) % n));
+    many_edges.push_back(std::make_pair(i, (i+1) % n));
+  }
+  graph og3(many_nodes.begin(), many_nodes.end(), many_edges.begin(), many_edges.end());
+  assert(og3.nodes() == static_cast<unsigned>(n));
+  assert(og3.edges() == 2*n);
+  assert(og3.existsEdge(100, (100*31+7) % n));
+  assert(og3.existsEdge(n-1, 0));
+  assert(!og3.existsEdge(101, 100));
+}
+
+void test_bulk_constructor(){
+  std::cout << "====== TEST_BULK_CONSTRUCTOR ======" << std::endl;
+
+  test_bulk_constructor_with<sparse_storage<> >();
+  test_bulk_constructor_with<bit_storage>();
+
+  //no hash functor, custom class
+  animal duck1 = animal(true, 2);
+  animal dog1 = animal(false, 4);
+  animal list[] = {duck1, dog1};
+  std::pair<animal, animal> edges[] = {{duck1, dog1}};
+  oriented_graph<animal, equal_animal, no_hash, dense_storage<> > og(list, list+2, edges, edges+1);
+  assert(og.existsEdge(duck1, dog1));
+  assert(og.edges() == 1);
+  animal dup_list[] = {duck1, dog1, animal(true, 2)};
+  M_ASSERT_THROW(
+      (oriented_graph<animal, equal_animal>(dup_list, dup_list+3, edges, edges)),
+      invalidNodeException
+      );
+}
+
+template <typename S>
+void test_batch_mutators_with(){
+  typedef oriented_graph<int, equal_int, hash_int, S> graph;
+  graph og;
+
+  //add nodes
+  std::vector<int> nodes;
+  for(int i=0; i<100; i++)
+    nodes.push_back(i);
+  og.addNodes(nodes.begin(), nodes.end());
+  assert(og.nodes() == 100);
+  assert(og.existsNode(99));
+
+  //all or nothing: 200 is new, 5 already exists
+  int invalid_nodes[] = {200, 5};
+  M_ASSERT_THROW(
+      og.addNodes(invalid_nodes, invalid_nodes+2),
+      invalidNodeException
+      );
+  int repeated_nodes[] = {300, 301, 300};
+  M_ASSERT_THROW(
+      og.addNodes(repeated_nodes, repeated_nodes+3),
+      invalidNodeException
+      );
+  assert(og.nodes() == 100);
+  assert(!og.existsNode(200));
+  assert(!og.existsNode(300));
+  assert(!og.existsNode(301));
+
+  //add edges
+  std::vector<std::pair<int, int> > edges;
+  for(int i=0; i<100; i++){
+    edges.push_back(std::make_pair(i, (i+1) % 100));
+    edges.push_back(std::make_pair(i, i));
+  }
+  og.addEdges(edges.begin(), edges.end());
+  assert(og.edges() == 200);
+  std::pair<int, int> invalid_edges[] = {{0, 50}, {0, 1}};
+  M_ASSERT_THROW(
+      og.addEdges(invalid_edges, invalid_edges+2),
+      invalidEdgeException
+      );
+  std::pair<int, int> repeated_edges[] = {{0, 50}, {0, 50}};
+  M_ASSERT_THROW(
+      og.addEdges(repeated_edges, repeated_edges+2),
+      invalidEdgeException
+      );
+  std::pair<int, int> unknown_edges[] = {{0, 50}, {0, 500}};
+  M_ASSERT_THROW(
+      og.addEdges(unknown_edges, unknown_edges+2),
+      invalidNodeException
+      );
+  assert(og.edges() == 200);
+  assert(!og.existsEdge(0, 50));
+
+  //remove edges
+  std::pair<int, int> removed_edges[] = {{10, 10}, {10, 11}, {20, 20}};
+  og.removeEdges(removed_edges, removed_edges+3);
+  assert(og.edges() == 197);
+  assert(!og.existsEdge(10, 11));
+  M_ASSERT_THROW(
+      og.removeEdges(removed_edges, removed_edges+3),
+      invalidEdgeException
+      );
+  std::pair<int, int> repeated_removal[] = {{30, 30}, {30, 30}};
+  M_ASSERT_THROW(
+      og.removeEdges(repeated_removal, repeated_removal+2),
+      invalidEdgeException
+      );
+  assert(og.edges() == 197);
+  assert(og.existsEdge(30, 30));
+
+  //remove nodes
+  int removed_nodes[] = {0, 99, 50, 63, 64};
+  int missing_nodes[] = {1, 2, 1000};
+  M_ASSERT_THROW(
+      og.removeNodes(missing_nodes, missing_nodes+3),
+      invalidNodeException
+      );
+  int repeated_removed_nodes[] = {1, 2, 1};
+  M_ASSERT_THROW(
+      og.removeNodes(repeated_removed_nodes, repeated_removed_nodes+3),
+      invalidNodeException
+      );
+  assert(og.nodes() == 100);
+  og.removeNodes(removed_nodes, removed_nodes+5);
+  assert(og.nodes() == 95);
+  int expected = 0;
+  for(int i=0; i<100; i++)
+    for(int j=0; j<100; j++){
+      const bool removed = (i == 0 || i == 99 || i == 50 || i == 63 || i == 64
+          || j == 0 || j == 99 || j == 50 || j == 63 || j == 64);
+      bool exists = !removed && (j == i || j == (i+1) % 100);
+      if((i == 10 && j == 10) || (i == 10 && j == 11) || (i == 20 && j == 20))
+        exists = false;
+      assert(og.existsEdge(i, j) == exists);
+      expected += exists;
+    }
+  assert(og.edges() == expected);
+
+  //the removed positions are clear
+  og.addNodes(removed_nodes, removed_nodes+5);
+  assert(og.edges() == expected);
+  assert(!og.existsEdge(63, 64));
+
+  //remove everything
+  og.removeNodes(nodes.begin(), nodes.end());
+  assert(og.nodes() == 0);
+  assert(og.edges() == 0);
+  og.addNodes(nodes.begin(), nodes.begin()+3);
+  assert(og.edges() == 0);
+}
+
+void test_batch_mutators(){
+  std::cout << "====== TEST_BATCH_MUTATORS ======" << std::endl;
+
+  test_batch_mutators_with<dense_storage<> >();
+  test_batch_mutators_with<bit_storage>();
+  test_batch_mutators_with<sparse_storage<> >();
+
+  //batches on a frozen sparse graph
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > og;
+  int nodes[] = {1, 2, 3, 4};
+  std::pair<int, int> edges[] = {{1, 2}, {2, 3}, {3, 4}, {4, 1}};
+  og.addNodes(nodes, nodes+4);
+  og.addEdges(edges, edges+4);
+  og.freeze();
+  int removed[] = {2};
+  og.removeNodes(removed, removed+1);
+  assert(og.edges() == 2);
+  assert(og.existsEdge(3, 4));
+  assert(og.existsEdge(4, 1));
+  og.removeEdges(edges+2, edges+4);
+  assert(og.edges() == 0);
+
+  //no hash functor
+  oriented_graph<char, equal_char> og1;
+  char chars[] = {'a', 'b', 'c'};
+  og1.addNodes(chars, chars+3);
+  char dup_chars[] = {'d', 'd'};
+  M_ASSERT_THROW(
+      og1.addNodes(dup_chars, dup_chars+2),
+      invalidNodeException
+      );
+  assert(og1.nodes() == 3);
+  og1.removeNodes(chars, chars+2);
+  assert(og1.nodes() == 1);
+  assert(og1.existsNode('c'));
+}
+
+template <typename H, typename S>
+void test_node_removal_with(bool freeze){
+  //random churn checked against a reference adjacency matrix indexed by label
+  const int labels = 90;
+  std::vector<std::vector<bool> > reference(labels, std::vector<bool>(labels, false));
+  std::vector<bool> present(labels, false);
+  oriented_graph<int, equal_int, H, S> og;
+  unsigned int seed = 12345;
+  int edges = 0;
+
+  for(int step=0; step<4000; step++){
+    seed = seed * 1103515245u + 12345u;
+    const int a = (seed >> 8) % labels;
+    const int b = (seed >> 16) % labels;
+    const int op = (seed >> 24) % 8;
+    if(op < 2){
+      if(present[a]){
+        for(int j=0; j<labels; j++){
+          edges -= reference[a][j];
+          if(j != a)
+            edges -= reference[j][a];
+          reference[a][j] = false;
+          reference[j][a] = false;
+        }
+        og.removeNode(a);
+        present[a] = false;
+      }
+      else{
+        og.addNode(a);
+        present[a] = true;
+      }
+    }
+    else if(present[a] && present[b]){
+      if(reference[a][b])
+        og.removeEdge(a, b);
+      else
+        og.addEdge(a, b);
+      reference[a][b] = !reference[a][b];
+      edges += reference[a][b] ? 1 : -1;
+    }
+    if(freeze && step % 500 == 0)
+      og.freeze();
+    if(step % 400 == 0){
+      assert(og.edges() == edges);
+      for(int i=0; i<labels; i++){
+        assert(og.existsNode(i) == present[i]);
+        for(int j=0; j<labels; j++)
+          assert(og.existsEdge(i, j) == (reference[i][j] && present[i] && present[j]));
+      }
+    }
+  }
+}
+
+void test_node_removal(){
+  std::cout << "====== TEST_NODE_REMOVAL ======" << std::endl;
+
+  test_node_removal_with<no_hash, dense_storage<> >(false);
+  test_node_removal_with<hash_int, bit_storage>(false);
+  test_node_removal_with<collide_int, bit_storage>(false);
+  test_node_removal_with<hash_int, sparse_storage<> >(false);
+  test_node_removal_with<hash_int, sparse_storage<> >(true);
+
+  //the frozen rows shrink with the graph, so the freed rows can be reused
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > frozen;
+  for(int n=0; n<8; n++)
+    frozen.addNode(n);
+  for(int n=0; n<8; n++)
+    frozen.addEdge(n, (n + 1) % 8);
+  frozen.freeze();
+  frozen.removeNode(7);
+  frozen.removeNode(2);
+  const int gone[] = {0, 5};
+  frozen.removeNodes(gone, gone+2);
+  assert(frozen.nodes() == 4 && frozen.edges() == 1 && frozen.existsEdge(3, 4));
+  frozen.shrink_to_fit();
+  frozen.addNode(9);
+  frozen.addEdge(9, 1);
+  frozen.addEdge(6, 9);
+  assert(frozen.edges() == 3 && frozen.existsEdge(3, 4) && frozen.existsEdge(6, 9));
+
+  //removal moves the last node in the freed position
+  char nodes[] = {'a', 'b', 'c', 'd'};
+  oriented_graph<char, equal_char, no_hash, bit_storage> og(nodes, 4);
+  og.addEdge('d', 'd');
+  og.addEdge('d', 'a');
+  og.addEdge('b', 'd');
+  og.removeNode('a');
+  assert(og.capacity() == 4);
+  oriented_graph<char, equal_char, no_hash, bit_storage>::const_iterator i = og.begin();
+  assert(*i == 'd');
+  assert(*(++i) == 'b');
+  assert(*(++i) == 'c');
+  assert(og.edges() == 2);
+  assert(og.existsEdge('d', 'd'));
+  assert(og.existsEdge('b', 'd'));
+  assert(!og.existsEdge('d', 'b'));
+
+  //removal of the last node
+  og.removeNode('c');
+  assert(og.nodes() == 2);
+  assert(og.edges() == 2);
+  og.addNode('c');
+  assert(!og.existsEdge('c', 'c'));
+  assert(!og.existsEdge('d', 'c'));
+}
+
+template <typename H, typename S>
+void check_degrees(const oriented_graph<int, equal_int, H, S> &og,
+    const std::vector<std::vector<bool> > &reference, const std::vector<bool> &present){
+  const int labels = static_cast<int>(present.size());
+  int edges = 0;
+  for(int i=0; i<labels; i++){
+    if(!present[i])
+      continue;
+    unsigned int out = 0, in = 0;
+    for(int j=0; j<labels; j++){
+      if(!present[j])
+        continue;
+      out += reference[i][j];
+      in += reference[j][i];
+    }
+    assert(og.outDegree(i) == out);
+    assert(og.inDegree(i) == in);
+    edges += out;
+  }
+  assert(og.edges() == edges);
+}
+
+template <typename H, typename S>
+void test_degrees_with(){
+  //random churn, including the batch mutators, checked against a reference matrix
+  const int labels = 40;
+  std::vector<std::vector<bool> > reference(labels, std::vector<bool>(labels, false));
+  std::vector<bool> present(labels, false);
+  oriented_graph<int, equal_int, H, S> og;
+  unsigned int seed = 777;
+
+  for(int step=0; step<3000; step++){
+    seed = seed * 1103515245u + 12345u;
+    const int a = (seed >> 8) % labels;
+    const int b = (seed >> 16) % labels;
+    const int op = (seed >> 24) % 16;
+    if(op < 3){
+      if(present[a]){
+        og.removeNode(a);
+        present[a] = false;
+        for(int j=0; j<labels; j++)
+          reference[a][j] = reference[j][a] = false;
+      }
+      else{
+        og.addNode(a);
+        present[a] = true;
+      }
+    }
+    else if(op == 3 && present[a] && present[b] && a != b){
+      int removed[] = {a, b};
+      og.removeNodes(removed, removed+2);
+      present[a] = present[b] = false;
+      for(int j=0; j<labels; j++){
+        reference[a][j] = reference[j][a] = false;
+        reference[b][j] = reference[j][b] = false;
+      }
+    }
+    else if(op == 4 && present[a] && present[b]){
+      //toggle all the edges from a to b and from b to a together
+      std::vector<std::pair<int, int> > add, remove;
+      (reference[a][b] ? remove : add).push_back(std::make_pair(a, b));
+      if(a != b)
+        (reference[b][a] ? remove : add).push_back(std::make_pair(b, a));
+      og.addEdges(add.begin(), add.end());
+      og.removeEdges(remove.begin(), remove.end());
+      reference[a][b] = !reference[a][b];
+      if(a != b)
+        reference[b][a] = !reference[b][a];
+    }
+    else if(present[a] && present[b]){
+      if(reference[a][b])
+        og.removeEdge(a, b);
+      else
+        og.addEdge(a, b);
+      reference[a][b] = !reference[a][b];
+    }
+    if(step % 300 == 0){
+      check_degrees(og, reference, present);
+      oriented_graph<int, equal_int, H, S> copy(og);
+      check_degrees(copy, reference, present);
+      copy.shrink_to_fit();
+      check_degrees(copy, reference, present);
+    }
+  }
+  check_degrees(og, reference, present);
+}
+
+void test_degrees(){
+  std::cout << "====== TEST_DEGREES ======" << std::endl;
+
+  test_degrees_with<no_hash, dense_storage<> >();
+  test_degrees_with<hash_int, bit_storage>();
+  test_degrees_with<hash_int, sparse_storage<> >();
+
+  //self loops count once towards the edges, and once in each direction
+  char nodes[] = {'a', 'b', 'c'};
+  std::pair<char, char> edges[] = {std::make_pair('a', 'a'), std::make_pair('a', 'b'), std::make_pair('c', 'a')};
+  oriented_graph<char, equal_char> og(nodes, nodes+3, edges, edges+3);
+  assert(og.edges() == 3);
+  assert(og.outDegree('a') == 2);
+  assert(og.inDegree('a') == 2);
+  assert(og.inDegree('b') == 1);
+  assert(og.outDegree('b') == 0);
+  og.removeNode('a');
+  assert(og.edges() == 0);
+  assert(og.outDegree('c') == 0);
+  assert(og.inDegree('b') == 0);
+
+  try{
+    og.outDegree('a');
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+}
+
+void test_simd_kernels_with(const simd_kernels &simd){
+  //odd lengths and offsets exercise the unaligned heads and the scalar tails
+  std::vector<int> cells(1000);
+  std::vector<std::uint64_t> words(300);
+  unsigned int seed = 99;
+  for(std::size_t c=0; c<cells.size(); c++){
+    seed = seed * 1103515245u + 12345u;
+    cells[c] = (seed >> 16) % 2;
+  }
+  for(std::size_t w=0; w<words.size(); w++){
+    seed = seed * 1103515245u + 12345u;
+    words[w] = (static_cast<std::uint64_t>(seed) << 32) ^ (seed * 2654435761u);
+  }
+  const std::size_t lengths[] = {0, 1, 3, 7, 8, 9, 31, 64, 255, 997};
+  for(std::size_t l=0; l<10; l++){
+    const std::size_t n = lengths[l];
+    assert(simd.sum(cells.data()+1, n) == simd_sum_scalar(cells.data()+1, n));
+    std::vector<unsigned int> acc(n+1, 5), expected(n+1, 5);
+    simd.accumulate(acc.data()+1, cells.data()+3, n);
+    simd_accumulate_scalar(expected.data()+1, cells.data()+3, n);
+    assert(acc == expected);
+    const std::size_t w = n % 290;
+    assert(simd.popcount(words.data()+1, w) == simd_popcount_scalar(words.data()+1, w));
+    std::vector<std::uint64_t> united(words.begin(), words.begin()+w+2), expected_united(united);
+    simd.unite(united.data()+1, words.data()+7, w);
+    simd_unite_scalar(expected_united.data()+1, words.data()+7, w);
+    assert(united == expected_united);
+    //distances of up to a million, and the large sentinel of the unreached nodes
+    std::vector<int> relaxed(n+1), expected_relaxed(n+1), paths(n+3);
+    for(std::size_t c=0; c<n+3; c++){
+      seed = seed * 1103515245u + 12345u;
+      paths[c] = (seed >> 8) % 16 == 0 ? 0x3fffffff : static_cast<int>((seed >> 8) % 1000000);
+      if(c <= n)
+        relaxed[c] = expected_relaxed[c] = static_cast<int>(seed % 2000000);
+    }
+    simd.relax(relaxed.data()+1, paths.data()+2, 12345, n);
+    simd_relax_scalar(expected_relaxed.data()+1, paths.data()+2, 12345, n);
+    assert(relaxed == expected_relaxed);
+    //the same above 32 bits
+    std::vector<long long> wide(n+1), expected_wide(n+1), wide_paths(n+3);
+    for(std::size_t c=0; c<n+3; c++){
+      wide_paths[c] = (static_cast<long long>(paths[c]) << 20) - 7;
+      if(c <= n)
+        wide[c] = expected_wide[c] = static_cast<long long>(relaxed[c]) << 20;
+    }
+    simd.relax_wide(wide.data()+1, wide_paths.data()+2, 5000000000ll, n);
+    simd_relax_wide_scalar(expected_wide.data()+1, wide_paths.data()+2, 5000000000ll, n);
+    assert(wide == expected_wide);
+  }
+}
+
+void test_simd_kernels(){
+  std::cout << "====== TEST_SIMD_KERNELS ======" << std::endl;
+  std::cout << "kernels: " << simd_dispatch().name << std::endl;
+
+  test_simd_kernels_with(simd_scalar());
+  test_simd_kernels_with(simd_dispatch());
+  #if OGRAPH_SIMD_X86
+  test_simd_kernels_with(simd_kernels{simd_sum_sse2, simd_accumulate_sse2, simd_popcount_scalar, simd_unite_sse2, simd_relax_sse2, simd_relax_wide_scalar, "sse2"});
+  if(__builtin_cpu_supports("popcnt"))
+    test_simd_kernels_with(simd_kernels{simd_sum_sse2, simd_accumulate_sse2, simd_popcount_popcnt, simd_unite_sse2, simd_relax_sse2, simd_relax_wide_scalar, "popcnt"});
+  #endif
+
+  //whole-matrix reductions agree with the edge counter
+  const int size = 150;
+  std::vector<int> nodes(size);
+  std::vector<std::pair<int, int> > edges;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j))
+        edges.push_back(std::make_pair(i, j));
+  }
+  oriented_graph<int, equal_int, hash_int, dense_storage<> > dense(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+  oriented_graph<int, equal_int, hash_int, bit_storage> bits(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+  //removeNodes recounts the degrees from the storage
+  int removed[] = {0, 77, 149};
+  dense.removeNodes(removed, removed+3);
+  bits.removeNodes(removed, removed+3);
+  int expected = 0;
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++)
+      if(i != 0 && i != 77 && i != 149 && j != 0 && j != 77 && j != 149)
+        expected += pattern_edge(i, j);
+  assert(dense.edges() == expected);
+  assert(bits.edges() == expected);
+  for(int i=1; i<size-1; i++){
+    if(i == 77)
+      continue;
+    unsigned int out = 0, in = 0;
+    for(int j=1; j<size-1; j++){
+      if(j == 77)
+        continue;
+      out += pattern_edge(i, j);
+      in += pattern_edge(j, i);
+    }
+    assert(dense.outDegree(i) == out && bits.outDegree(i) == out);
+    assert(dense.inDegree(i) == in && bits.inDegree(i) == in);
+  }
+}
+
+template <typename H, typename S>
+void test_neighbors_with(bool freeze){
+  const int size = 70;
+  std::vector<int> nodes(size);
+  std::vector<std::pair<int, int> > edges;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j))
+        edges.push_back(std::make_pair(i, j));
+  }
+  oriented_graph<int, equal_int, H, S> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+  og.removeNode(10);
+  og.addEdge(69, 3);
+  if(freeze)
+    og.freeze();
+
+  for(int i=0; i<size; i++){
+    if(i == 10)
+      continue;
+    std::vector<bool> out(size, false), in(size, false);
+    unsigned int count = 0;
+    for(const int &j : og.successors(i)){
+      assert(og.existsEdge(i, j) && !out[j]);
+      out[j] = true;
+      count++;
+    }
+    assert(count == og.outDegree(i));
+    count = 0;
+    typename oriented_graph<int, equal_int, H, S>::neighbor_range range = og.predecessors(i);
+    for(typename oriented_graph<int, equal_int, H, S>::neighbor_iterator j = range.begin(); j != range.end(); j++){
+      assert(og.existsEdge(*j, i) && !in[*j]);
+      in[*j] = true;
+      count++;
+    }
+    assert(count == og.inDegree(i));
+  }
+}
+
+void test_neighbors(){
+  std::cout << "====== TEST_NEIGHBORS ======" << std::endl;
+
+  test_neighbors_with<no_hash, dense_storage<> >(false);
+  test_neighbors_with<hash_int, bit_storage>(false);
+  test_neighbors_with<hash_int, sparse_storage<> >(false);
+  test_neighbors_with<hash_int, sparse_storage<> >(true);
+
+  //neighbours are visited in the order of the node positions
+  char nodes[] = {'a', 'b', 'c', 'd'};
+  oriented_graph<char, equal_char> og(nodes, 4);
+  og.addEdge('b', 'd');
+  og.addEdge('b', 'a');
+  og.addEdge('b', 'b');
+  og.addEdge('c', 'b');
+  oriented_graph<char, equal_char>::neighbor_range succ = og.successors('b');
+  oriented_graph<char, equal_char>::neighbor_iterator i = succ.begin();
+  assert(*i == 'a');
+  assert(*(++i) == 'b');
+  assert(*(++i) == 'd');
+  assert(++i == succ.end());
+  oriented_graph<char, equal_char>::neighbor_range pred = og.predecessors('b');
+  i = pred.begin();
+  assert(*i == 'b');
+  assert(*(++i) == 'c');
+  assert(++i == pred.end());
+  assert(og.successors('d').begin() == og.successors('d').end());
+
+  try{
+    og.successors('z');
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+}
+
+template <typename H, typename S>
+void test_edge_iterator_with(){
+  const int size = 80;
+  std::vector<int> nodes(size);
+  std::vector<std::pair<int, int> > edges;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    //leave some rows empty
+    for(int j=0; j<size; j++)
+      if(i % 3 != 0 && pattern_edge(i, j))
+        edges.push_back(std::make_pair(i, j));
+  }
+  oriented_graph<int, equal_int, H, S> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+  og.removeNode(4);
+
+  std::vector<std::vector<bool> > seen(size, std::vector<bool>(size, false));
+  int count = 0;
+  typename oriented_graph<int, equal_int, H, S>::edge_iterator e = og.edge_begin(), prev = e;
+  for(; e != og.edge_end(); prev = e++){
+    const std::pair<const int&, const int&> edge = *e;
+    assert(og.existsEdge(edge.first, edge.second));
+    assert(!seen[edge.first][edge.second]);
+    seen[edge.first][edge.second] = true;
+    //row order on the positions
+    if(count > 0)
+      assert(prev.from_index() < e.from_index() ||
+        (prev.from_index() == e.from_index() && prev.to_index() < e.to_index()));
+    count++;
+  }
+  assert(count == og.edges());
+
+  //the proxy reference makes it an input iterator, with values that own the labels
+  typedef typename oriented_graph<int, equal_int, H, S>::edge_iterator edge_iterator;
+  static_assert(std::is_same<typename std::iterator_traits<edge_iterator>::iterator_category, std::input_iterator_tag>::value,
+    "edge_iterator is an input iterator");
+  static_assert(std::is_same<typename std::iterator_traits<edge_iterator>::value_type, std::pair<int, int> >::value,
+    "the values of edge_iterator are pairs of labels");
+  const std::vector<std::pair<int, int> > stored(og.edge_begin(), og.edge_end());
+  const std::pair<int, int> first_edge(*og.edge_begin());
+  assert(stored.size() == std::size_t(og.edges()) && stored.front() == first_edge);
+
+  //multipass: a copy walks the same edges, and equal iterators stay equal
+  assert(std::distance(og.edge_begin(), og.edge_end()) == og.edges());
+  edge_iterator first = og.edge_begin(), second = first;
+  for(; first != og.edge_end(); ++first, ++second){
+    assert(first == second);
+    assert(first.from() == (*second).first && first.to() == (*second).second);
+    assert(std::next(first) == std::next(second));
+  }
+  assert(second == og.edge_end());
+  assert(edge_iterator() == edge_iterator());
+}
+
+void test_edge_iterator(){
+  std::cout << "====== TEST_EDGE_ITERATOR ======" << std::endl;
+
+  test_edge_iterator_with<no_hash, dense_storage<> >();
+  test_edge_iterator_with<hash_int, bit_storage>();
+  test_edge_iterator_with<hash_int, sparse_storage<> >();
+
+  //empty graphs
+  oriented_graph<char, equal_char> empty;
+  assert(empty.edge_begin() == empty.edge_end());
+  char nodes[] = {'a', 'b', 'c'};
+  oriented_graph<char, equal_char> og(nodes, 3);
+  assert(og.edge_begin() == og.edge_end());
+
+  og.addEdge('c', 'a');
+  og.addEdge('a', 'c');
+  oriented_graph<char, equal_char>::edge_iterator e = og.edge_begin();
+  assert(e.from() == 'a' && e.to() == 'c');
+  e++;
+  assert((*e).first == 'c' && (*e).second == 'a');
+  assert(++e == og.edge_end());
+}
+
+template <typename H, typename S>
+void test_traversal_with(){
+  //reachability checked against a closure of the reference matrix
+  const int size = 60;
+  std::vector<int> nodes(size);
+  std::vector<std::pair<int, int> > edges;
+  std::vector<std::vector<bool> > reach(size, std::vector<bool>(size, false));
+  unsigned int seed = 4242;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    reach[i][i] = true;
+    for(int j=0; j<size; j++){
+      seed = seed * 1103515245u + 12345u;
+      if((seed >> 16) % 40 == 0){
+        edges.push_back(std::make_pair(i, j));
+        reach[i][j] = true;
+      }
+    }
+  }
+  for(int k=0; k<size; k++)
+    for(int i=0; i<size; i++)
+      for(int j=0; j<size; j++)
+        if(reach[i][k] && reach[k][j])
+          reach[i][j] = true;
+  oriented_graph<int, equal_int, H, S> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+
+  for(int i=0; i<size; i++){
+    std::vector<int> reached = og.reachableFrom(i);
+    assert(reached[0] == i);
+    std::vector<bool> in_bfs(size, false), in_dfs(size, false);
+    for(std::size_t r=0; r<reached.size(); r++){
+      assert(reach[i][reached[r]] && !in_bfs[reached[r]]);
+      in_bfs[reached[r]] = true;
+    }
+    og.dfs(i, [&](const int &n){
+      assert(!in_dfs[n]);
+      in_dfs[n] = true;
+    });
+    for(int j=0; j<size; j++){
+      assert(in_bfs[j] == reach[i][j]);
+      assert(in_dfs[j] == reach[i][j]);
+      assert(og.hasPath(i, j) == reach[i][j]);
+    }
+  }
+}
+
+void test_traversal(){
+  std::cout << "====== TEST_TRAVERSAL ======" << std::endl;
+
+  test_traversal_with<no_hash, dense_storage<> >();
+  test_traversal_with<hash_int, bit_storage>();
+  test_traversal_with<hash_int, sparse_storage<> >();
+
+  //visit orders on a small tree: a -> b, a -> c, b -> d, c -> d
+  char nodes[] = {'a', 'b', 'c', 'd', 'e'};
+  oriented_graph<char, equal_char> og(nodes, 5);
+  og.addEdge('a', 'b');
+  og.addEdge('a', 'c');
+  og.addEdge('b', 'd');
+  og.addEdge('c', 'd');
+  og.addEdge('d', 'a');
+  std::vector<char> order;
+  og.bfs('b', [&](const char &n){ order.push_back(n); });
+  assert(order.size() == 4 && order[0] == 'b' && order[1] == 'd' && order[2] == 'a' && order[3] == 'c');
+  order.clear();
+  og.dfs('a', [&](const char &n){ order.push_back(n); });
+  assert(order.size() == 4 && order[0] == 'a' && order[1] == 'b' && order[2] == 'd' && order[3] == 'c');
+
+  //a visitor returning true stops the visit
+  order.clear();
+  og.dfs('a', [&](const char &n){ order.push_back(n); return n == 'b'; });
+  assert(order.size() == 2);
+  assert(!og.hasPath('a', 'e'));
+  assert(og.hasPath('e', 'e'));
+  assert(og.hasPath('c', 'b'));
+
+  try{
+    og.hasPath('a', 'z');
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+
+  //a long chain does not overflow the stack of the depth first visit
+  const int length = 20000;
+  std::vector<int> chain(length);
+  std::vector<std::pair<int, int> > links;
+  for(int i=0; i<length; i++){
+    chain[i] = i;
+    if(i > 0)
+      links.push_back(std::make_pair(i-1, i));
+  }
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > long_graph(chain.begin(), chain.end(), links.begin(), links.end());
+  int last = -1;
+  long_graph.dfs(0, [&](const int &n){ assert(n == last+1); last = n; });
+  assert(last == length-1);
+  assert(long_graph.hasPath(0, length-1));
+  assert(!long_graph.hasPath(length-1, 0));
+}
+
+template <typename H, typename S>
+void test_parallel_bfs_with(int size, int degree){
+  //random graph with a few long chains, so both directions of the visit are used
+  std::vector<int> nodes(size);
+  std::vector<std::vector<int> > adjacency(size);
+  std::vector<std::pair<int, int> > edges;
+  unsigned int seed = 31337;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    std::vector<bool> taken(size, false);
+    for(int d=0; d<degree; d++){
+      seed = seed * 1103515245u + 12345u;
+      const int j = (seed >> 8) % size;
+      if(!taken[j] && (i % 7 != 0 || d == 0)){
+        taken[j] = true;
+        edges.push_back(std::make_pair(i, j));
+        adjacency[i].push_back(j);
+      }
+    }
+  }
+  oriented_graph<int, equal_int, H, S> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+
+  //reference distances
+  std::vector<int> distance(size, -1), queue(1, 0);
+  distance[0] = 0;
+  for(std::size_t q=0; q<queue.size(); q++)
+    for(std::size_t a=0; a<adjacency[queue[q]].size(); a++){
+      const int j = adjacency[queue[q]][a];
+      if(distance[j] == -1){
+        distance[j] = distance[queue[q]] + 1;
+        queue.push_back(j);
+      }
+    }
+
+  std::vector<std::pair<int, unsigned int> > serial;
+  og.parallelBfs(0, [&](const int &n, unsigned int depth){ serial.push_back(std::make_pair(n, depth)); }, 1);
+  assert(serial.size() == queue.size());
+  for(std::size_t r=0; r<serial.size(); r++){
+    assert(distance[serial[r].first] == static_cast<int>(serial[r].second));
+    if(r > 0)
+      assert(serial[r-1].second <= serial[r].second);
+  }
+
+  //same visit, whatever the amount of threads
+  const unsigned int threads[] = {2, 3, 8};
+  for(int t=0; t<3; t++){
+    std::vector<std::pair<int, unsigned int> > parallel;
+    og.parallelBfs(0, [&](const int &n, unsigned int depth){ parallel.push_back(std::make_pair(n, depth)); }, threads[t]);
+    assert(parallel == serial);
+  }
+}
+
+void test_parallel_bfs(){
+  std::cout << "====== TEST_PARALLEL_BFS ======" << std::endl;
+
+  test_parallel_bfs_with<no_hash, dense_storage<> >(150, 3);
+  test_parallel_bfs_with<hash_int, bit_storage>(300, 6);
+  test_parallel_bfs_with<hash_int, sparse_storage<> >(3000, 8);
+  test_parallel_bfs_with<hash_int, sparse_storage<> >(2000, 1);
+
+  //a single node, and unreachable nodes
+  char nodes[] = {'a', 'b'};
+  oriented_graph<char, equal_char> og(nodes, 2);
+  og.addEdge('b', 'a');
+  int visits = 0;
+  og.parallelBfs('a', [&](const char &n, unsigned int depth){
+    assert(n == 'a' && depth == 0);
+    visits++;
+  }, 4);
+  assert(visits == 1);
+
+  try{
+    og.parallelBfs('z', [](const char &, unsigned int){});
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+
+  //exceptions in a step are rethrown by the team
+  parallel_team team(3);
+  try{
+    team.run([](unsigned t){
+      if(t == 2)
+        throw invalidEdgeException();
+    });
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+  int ran = 0;
+  std::mutex lock;
+  team.run([&](unsigned){
+    std::lock_guard<std::mutex> guard(lock);
+    ran++;
+  });
+  assert(ran == 3);
+}
+
+template <typename H, typename S>
+void test_transitive_closure_with(int size, unsigned int threads){
+  std::vector<int> nodes(size);
+  std::vector<std::pair<int, int> > edges;
+  std::vector<std::vector<bool> > reach(size, std::vector<bool>(size, false));
+  unsigned int seed = 2024 + size;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    for(int j=0; j<size; j++){
+      seed = seed * 1103515245u + 12345u;
+      if((seed >> 16) % (size * 2) == 0){
+        edges.push_back(std::make_pair(i, j));
+        reach[i][j] = true;
+      }
+    }
+  }
+  for(int k=0; k<size; k++)
+    for(int i=0; i<size; i++)
+      for(int j=0; j<size; j++)
+        if(reach[i][k] && reach[k][j])
+          reach[i][j] = true;
+  oriented_graph<int, equal_int, H, S> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+
+  oriented_graph<int, equal_int, H, S> closure = og.transitiveClosure(threads);
+  assert(closure.nodes() == static_cast<unsigned int>(size));
+  int count = 0;
+  for(int i=0; i<size; i++){
+    unsigned int out = 0;
+    for(int j=0; j<size; j++){
+      assert(closure.existsEdge(i, j) == reach[i][j]);
+      count += reach[i][j];
+      out += reach[i][j];
+    }
+    assert(closure.outDegree(i) == out);
+  }
+  assert(closure.edges() == count);
+  assert(og.edges() == static_cast<int>(edges.size()));
+}
+
+void test_transitive_closure(){
+  std::cout << "====== TEST_TRANSITIVE_CLOSURE ======" << std::endl;
+
+  test_transitive_closure_with<no_hash, dense_storage<> >(70, 1);
+  test_transitive_closure_with<hash_int, bit_storage>(200, 3);
+  test_transitive_closure_with<hash_int, sparse_storage<> >(129, 2);
+  test_transitive_closure_with<hash_int, bit_storage>(64, 4);
+
+  //self loops only on cycles
+  char nodes[] = {'a', 'b', 'c', 'd'};
+  oriented_graph<char, equal_char> og(nodes, 4);
+  og.addEdge('a', 'b');
+  og.addEdge('b', 'c');
+  og.addEdge('c', 'b');
+  oriented_graph<char, equal_char> closure = og.transitiveClosure(1);
+  assert(closure.edges() == 6);
+  assert(closure.existsEdge('a', 'c'));
+  assert(closure.existsEdge('b', 'b'));
+  assert(!closure.existsEdge('a', 'a'));
+  assert(!closure.existsEdge('d', 'd'));
+
+  oriented_graph<char, equal_char> empty;
+  assert(empty.transitiveClosure().nodes() == 0);
+}
+
+template <typename H, typename S>
+void test_components_with(int size){
+  std::vector<int> nodes(size);
+  std::vector<std::pair<int, int> > edges;
+  unsigned int seed = 555 + size;
+  for(int i=0; i<size; i++){
+    nodes[i] = i;
+    for(int j=0; j<size; j++){
+      seed = seed * 1103515245u + 12345u;
+      if((seed >> 16) % (size + size/2) == 0)
+        edges.push_back(std::make_pair(i, j));
+    }
+  }
+  oriented_graph<int, equal_int, H, S> og(nodes.begin(), nodes.end(), edges.begin(), edges.end());
+  og.removeNode(size/2);
+
+  const std::vector<unsigned int> component = og.stronglyConnectedComponents();
+  std::vector<int> label;
+  for(typename oriented_graph<int, equal_int, H, S>::const_iterator n = og.begin(); n != og.end(); n++)
+    label.push_back(*n);
+  assert(component.size() == label.size());
+
+  //nodes are in the same component when they reach each other
+  for(std::size_t a=0; a<label.size(); a++)
+    for(std::size_t b=0; b<label.size(); b++){
+      const bool same = og.hasPath(label[a], label[b]) && og.hasPath(label[b], label[a]);
+      assert((component[a] == component[b]) == same);
+      if(og.existsEdge(label[a], label[b]))
+        assert(component[a] <= component[b]);
+    }
+
+  typename oriented_graph<int, equal_int, H, S>::condensation_type dag = og.condensation();
+  unsigned int count = 0;
+  for(std::size_t a=0; a<component.size(); a++)
+    count = std::max(count, component[a]+1);
+  assert(dag.nodes() == count);
+  for(std::size_t a=0; a<label.size(); a++)
+    for(std::size_t b=0; b<label.size(); b++)
+      if(component[a] != component[b] && og.existsEdge(label[a], label[b]))
+        assert(dag.existsEdge(component[a], component[b]));
+  for(unsigned int c=0; c<count; c++)
+    assert(!dag.existsEdge(c, c));
+}
+
+void test_components(){
+  std::cout << "====== TEST_COMPONENTS ======" << std::endl;
+
+  test_components_with<no_hash, dense_storage<> >(40);
+  test_components_with<hash_int, bit_storage>(90);
+  test_components_with<hash_int, sparse_storage<> >(120);
+
+  // a <-> b -> c <-> d, e alone
+  char nodes[] = {'a', 'b', 'c', 'd', 'e'};
+  oriented_graph<char, equal_char, no_hash, sparse_storage<> > og(nodes, 5);
+  og.addEdge('a', 'b');
+  og.addEdge('b', 'a');
+  og.addEdge('b', 'c');
+  og.addEdge('c', 'd');
+  og.addEdge('d', 'c');
+  std::vector<unsigned int> component = og.stronglyConnectedComponents();
+  assert(component[0] == component[1]);
+  assert(component[2] == component[3]);
+  assert(component[0] < component[2]);
+  assert(component[4] != component[0] && component[4] != component[2]);
+  oriented_graph<char, equal_char, no_hash, sparse_storage<> >::condensation_type dag = og.condensation();
+  assert(dag.nodes() == 3);
+  assert(dag.edges() == 1);
+  assert(dag.existsEdge(component[0], component[2]));
+
+  //a long chain closed in a cycle does not overflow the stack
+  const int length = 200000;
+  std::vector<int> chain(length);
+  std::vector<std::pair<int, int> > links;
+  for(int i=0; i<length; i++){
+    chain[i] = i;
+    links.push_back(std::make_pair(i, (i+1) % length));
+  }
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > cycle(chain.begin(), chain.end(), links.begin(), links.end());
+  component = cycle.stronglyConnectedComponents();
+  for(int i=0; i<length; i++)
+    assert(component[i] == 0);
+  cycle.removeEdge(length-1, 0);
+  component = cycle.stronglyConnectedComponents();
+  for(int i=0; i<length; i++)
+    assert(component[i] == static_cast<unsigned int>(i));
+  assert(cycle.condensation().edges() == length-1);
+}
+
+template <typename H, typename S>
+void check_topological_order(const oriented_graph<int, equal_int, H, S> &og, int labels){
+  const std::vector<int> order = og.topologicalOrder();
+  assert(order.size() == og.nodes());
+  std::vector<int> rank(labels, -1);
+  for(std::size_t r=0; r<order.size(); r++){
+    assert(rank[order[r]] == -1);
+    rank[order[r]] = static_cast<int>(r);
+  }
+  for(typename oriented_graph<int, equal_int, H, S>::edge_iterator e = og.edge_begin(); e != og.edge_end(); e++)
+    assert(rank[e.from()] < rank[e.to()]);
+}
+
+template <typename H, typename S>
+void test_acyclic_with(){
+  const int labels = 60;
+  oriented_graph<int, equal_int, H, S> og;
+  og.setAcyclic(true);
+  std::vector<bool> present(labels, false);
+  unsigned int seed = 8080;
+  for(int step=0; step<3000; step++){
+    seed = seed * 1103515245u + 12345u;
+    const int a = (seed >> 8) % labels;
+    const int b = (seed >> 16) % labels;
+    const int op = (seed >> 24) % 20;
+    if(op < 2){
+      if(present[a])
+        og.removeNode(a);
+      else
+        og.addNode(a);
+      present[a] = !present[a];
+    }
+    else if(op == 2 && present[a] && present[b] && a != b){
+      int removed[] = {a, b};
+      og.removeNodes(removed, removed+2);
+      present[a] = present[b] = false;
+    }
+    else if(op == 3 && !present[a] && !present[b] && a != b){
+      int added[] = {a, b};
+      og.addNodes(added, added+2);
+      present[a] = present[b] = true;
+    }
+    else if(op == 4 && present[a] && present[b] && a != b && !og.existsEdge(a, b) && !og.existsEdge(b, a)){
+      //both directions together always close a cycle
+      std::pair<int, int> both[] = {std::make_pair(a, b), std::make_pair(b, a)};
+      const int edges = og.edges();
+      try{
+        og.addEdges(both, both+2);
+        assert(false);
+      }
+      catch(cycleException &e){}
+      assert(og.edges() == edges);
+    }
+    else if(present[a] && present[b]){
+      if(og.existsEdge(a, b))
+        og.removeEdge(a, b);
+      else{
+        const bool closes = og.hasPath(b, a);
+        try{
+          og.addEdge(a, b);
+          assert(!closes);
+        }
+        catch(cycleException &e){
+          assert(closes);
+          assert(!og.existsEdge(a, b));
+        }
+      }
+    }
+    if(step % 250 == 0){
+      check_topological_order(og, labels);
+      oriented_graph<int, equal_int, H, S> copy(og);
+      assert(copy.acyclic());
+      check_topological_order(copy, labels);
+    }
+  }
+  check_topological_order(og, labels);
+  og.setAcyclic(false);
+  check_topological_order(og, labels);
+}
+
+void test_acyclic(){
+  std::cout << "====== TEST_ACYCLIC ======" << std::endl;
+
+  test_acyclic_with<no_hash, dense_storage<> >();
+  test_acyclic_with<hash_int, bit_storage>();
+  test_acyclic_with<hash_int, sparse_storage<> >();
+
+  char nodes[] = {'a', 'b', 'c', 'd'};
+  oriented_graph<char, equal_char> og(nodes, 4);
+  og.addEdge('d', 'c');
+  og.addEdge('c', 'b');
+  og.addEdge('b', 'a');
+  std::vector<char> order = og.topologicalOrder();
+  assert(order[0] == 'd' && order[1] == 'c' && order[2] == 'b' && order[3] == 'a');
+
+  //enabling the mode needs an acyclic graph
+  og.addEdge('a', 'd');
+  try{
+    og.topologicalOrder();
+    assert(false);
+  }
+  catch(cycleException &e){}
+  try{
+    og.setAcyclic(true);
+    assert(false);
+  }
+  catch(const std::exception &e){
+    //the message is reachable from the base class
+    assert(std::string(e.what()) == "Cycle in the graph");
+  }
+  assert(!og.acyclic());
+
+  og.removeEdge('a', 'd');
+  og.setAcyclic(true);
+  try{
+    og.addEdge('a', 'a');
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+  //an edge along the order is accepted without any visit, one against it reorders the nodes
+  og.addEdge('d', 'a');
+  og.removeEdge('c', 'b');
+  og.addEdge('b', 'c');
+  order = og.topologicalOrder();
+  assert(order[0] == 'd' && order[1] == 'b' && order[2] == 'c' && order[3] == 'a');
+}
+
+/**
+ * @brief a weight that cannot be built from an int
+ */
+struct distance_km {
+  double km;
+};
+
+template <typename H, typename S>
+void test_weights_with(bool freeze){
+  typedef oriented_graph<int, equal_int, H, S> graph;
+  const int labels = 40;
+  graph og;
+  for(int i=0; i<labels; i++)
+    og.addNode(i);
+  //reference weights, 0 for a missing edge
+  std::vector<std::vector<double> > weight(labels, std::vector<double>(labels, 0));
+  unsigned int seed = 1848;
+  for(int step=0; step<2000; step++){
+    seed = seed * 1103515245u + 12345u;
+    const int a = (seed >> 8) % labels;
+    const int b = (seed >> 16) % labels;
+    const int op = (seed >> 24) % 40;
+    if(op == 0 && og.existsNode(a)){
+      og.removeNode(a);
+      for(int i=0; i<labels; i++)
+        weight[a][i] = weight[i][a] = 0;
+    }
+    else if(op == 1 && og.existsNode(a) && og.existsNode(b) && a != b){
+      int removed[] = {a, b};
+      og.removeNodes(removed, removed+2);
+      for(int i=0; i<labels; i++)
+        weight[a][i] = weight[i][a] = weight[b][i] = weight[i][b] = 0;
+    }
+    else if(op == 2 && !og.existsNode(a))
+      og.addNode(a);
+    else if(op == 3 && freeze)
+      og.freeze();
+    else if(og.existsNode(a) && og.existsNode(b)){
+      if(og.existsEdge(a, b)){
+        og.removeEdge(a, b);
+        weight[a][b] = 0;
+      }
+      else{
+        og.addEdge(a, b, step + 0.5);
+        weight[a][b] = step + 0.5;
+      }
+    }
+  }
+  const graph copy(og);
+  for(int a=0; a<labels; a++)
+    for(int b=0; b<labels; b++)
+      if(weight[a][b] != 0){
+        assert(og.weight(a, b) == weight[a][b]);
+        assert(copy.weight(a, b) == weight[a][b]);
+      }
+      else
+        assert(!og.existsEdge(a, b));
+}
+
+void test_weights(){
+  std::cout << "====== TEST_WEIGHTS ======" << std::endl;
+
+  test_weights_with<no_hash, dense_storage<double> >(false);
+  test_weights_with<hash_int, sparse_storage<double> >(false);
+  test_weights_with<hash_int, sparse_storage<double> >(true);
+
+  //the default weight is 1, and the edges of a range get the default weight
+  int nodes[] = {1, 2, 3};
+  std::pair<int, int> edges[] = {std::make_pair(1, 2), std::make_pair(2, 3)};
+  oriented_graph<int, equal_int, hash_int, sparse_storage<int> > og(nodes, nodes+3, edges, edges+2);
+  assert(og.weight(1, 2) == 1 && og.weight(2, 3) == 1);
+  og.addEdge(3, 1, -7);
+  og.addEdge(1, 3);
+  assert(og.weight(3, 1) == -7 && og.weight(1, 3) == 1);
+  try{
+    og.weight(2, 1);
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+  try{
+    og.weight(1, 4);
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+
+  //the closure gets the default weight on every edge
+  oriented_graph<int, equal_int, hash_int, dense_storage<int> > dense(nodes, nodes+3, edges, edges+2);
+  dense.removeEdge(1, 2);
+  dense.addEdge(1, 2, 5);
+  assert(dense.weight(1, 2) == 5);
+  assert(dense.transitiveClosure().weight(1, 3) == 1);
+
+  //without an int constructor, the default weight is value initialized
+  oriented_graph<int, equal_int, hash_int, dense_storage<distance_km> > roads(nodes, nodes+3, edges, edges+2);
+  assert(roads.weight(1, 2).km == 0);
+  roads.addEdge(3, 1, distance_km{12.5});
+  assert(roads.weight(3, 1).km == 12.5);
+}
+
+/**
+ * @brief check the shortest paths from every node against Bellman-Ford
+ *
+ * @param unit true to give weight 1 to every edge
+ */
+template <typename H, typename S>
+void test_shortest_paths_with(int labels, int degree, bool unit){
+  typedef oriented_graph<int, equal_int, H, S> graph;
+  graph og;
+  for(int i=0; i<labels; i++)
+    og.addNode(i);
+  unsigned int seed = 1959;
+  for(int i=0; i<labels; i++)
+    for(int d=0; d<degree; d++){
+      seed = seed * 1103515245u + 12345u;
+      const int j = (seed >> 8) % labels;
+      if(!og.existsEdge(i, j))
+        og.addEdge(i, j, unit ? 1 : static_cast<int>((seed >> 20) % 10));
+    }
+  //shuffle the positions
+  for(int i=0; i<labels; i+=7)
+    og.removeNode(i);
+
+  //the index of every label, in const_iterator order
+  std::vector<int> index(labels, -1);
+  std::vector<int> label;
+  for(typename graph::const_iterator it = og.begin(); it != og.end(); it++){
+    index[*it] = static_cast<int>(label.size());
+    label.push_back(*it);
+  }
+  const int n = static_cast<int>(label.size());
+
+  typename graph::shortest_paths paths;
+  for(int s=0; s<n; s++){
+    og.shortestPaths(label[s], paths);
+    std::vector<long> reference(n, -1);
+    reference[s] = 0;
+    for(bool changed = true; changed; ){
+      changed = false;
+      for(typename graph::edge_iterator e = og.edge_begin(); e != og.edge_end(); e++){
+        const int a = index[e.from()], b = index[e.to()];
+        const long d = reference[a] + og.weight(e.from(), e.to());
+        if(reference[a] != -1 && (reference[b] == -1 || d < reference[b])){
+          reference[b] = d;
+          changed = true;
+        }
+      }
+    }
+    assert(static_cast<int>(paths.distances().size()) == n);
+    for(int i=0; i<n; i++){
+      if(reference[i] == -1){
+        assert(!paths.reached(i));
+        assert(paths.parents()[i] == graph::shortest_paths::none);
+        continue;
+      }
+      assert(paths.reached(i));
+      assert(paths.distances()[i] == reference[i]);
+      const unsigned int p = paths.parents()[i];
+      if(i == s)
+        assert(p == graph::shortest_paths::none);
+      else
+        assert(paths.distances()[p] + og.weight(label[p], label[i]) == paths.distances()[i]);
+    }
+  }
+}
+
+void test_shortest_paths(){
+  std::cout << "====== TEST_SHORTEST_PATHS ======" << std::endl;
+
+  test_shortest_paths_with<no_hash, dense_storage<int> >(40, 3, false);
+  test_shortest_paths_with<hash_int, sparse_storage<int> >(90, 3, false);
+  test_shortest_paths_with<hash_int, sparse_storage<int> >(90, 2, true);
+  test_shortest_paths_with<hash_int, sparse_storage<unsigned int> >(90, 3, false);
+  test_shortest_paths_with<hash_int, sparse_storage<double> >(90, 3, false);
+
+  //without weights, the distances count the edges
+  char nodes[] = {'a', 'b', 'c', 'd', 'e'};
+  oriented_graph<char, equal_char> og(nodes, 5);
+  og.addEdge('a', 'b');
+  og.addEdge('b', 'c');
+  og.addEdge('a', 'c');
+  og.addEdge('c', 'd');
+  oriented_graph<char, equal_char>::shortest_paths paths = og.shortestPaths('a');
+  assert(paths.distances()[0] == 0 && paths.distances()[1] == 1);
+  assert(paths.distances()[2] == 1 && paths.distances()[3] == 2);
+  assert(paths.parents()[3] == 2 && !paths.reached(4));
+  try{
+    og.shortestPaths('z');
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+
+  //a longer path can be lighter
+  oriented_graph<char, equal_char, no_hash, sparse_storage<double> > roads(nodes, 5);
+  roads.addEdge('a', 'e', 10);
+  roads.addEdge('a', 'b', 0.5);
+  roads.addEdge('b', 'c', 0.5);
+  roads.addEdge('c', 'e', 0.5);
+  oriented_graph<char, equal_char, no_hash, sparse_storage<double> >::shortest_paths weighted = roads.shortestPaths('a');
+  assert(weighted.distances()[4] == 1.5 && weighted.parents()[4] == 2);
+
+  //the lengths are summed in 64 bits, a path can be longer than the largest weight
+  std::vector<int> chain(300);
+  for(int i=0; i<300; i++)
+    chain[i] = i;
+  oriented_graph<int, equal_int, hash_int, sparse_storage<unsigned char> > narrow(chain.data(), 300);
+  oriented_graph<int, equal_int, hash_int, sparse_storage<int> > wide(chain.data(), 300);
+  for(int i=0; i<299; i++){
+    narrow.addEdge(i, i+1, 200);
+    wide.addEdge(i, i+1, 2000000000);
+  }
+  assert(narrow.shortestPaths(0).distances()[299] == 299ull * 200);
+  assert(narrow.allPairsShortestPaths()(0, 299) == 299ull * 200);
+  assert(wide.shortestPaths(0).distances()[299] == 299ll * 2000000000);
+  assert(wide.allPairsShortestPaths()(1, 299) == 298ll * 2000000000);
+
+  roads.addEdge('e', 'd', -1);
+  roads.shortestPaths('d', weighted);
+  assert(weighted.reached(3) && !weighted.reached(0));
+  try{
+    roads.shortestPaths('a', weighted);
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+}
+
+template <typename H, typename S>
+void test_all_pairs_with(int labels, int degree, unsigned threads){
+  typedef oriented_graph<int, equal_int, H, S> graph;
+  graph og;
+  for(int i=0; i<labels; i++)
+    og.addNode(i);
+  unsigned int seed = 2020;
+  for(int i=0; i<labels; i++)
+    for(int d=0; d<degree; d++){
+      seed = seed * 1103515245u + 12345u;
+      const int j = (seed >> 8) % labels;
+      if(og.existsEdge(i, j))
+        continue;
+      if constexpr (std::is_same<typename graph::weight_type, no_weight>::value)
+        og.addEdge(i, j);
+      else
+        og.addEdge(i, j, static_cast<int>((seed >> 20) % 50));
+    }
+  og.removeNode(labels / 2);
+
+  const typename graph::distance_matrix all = og.allPairsShortestPaths(threads);
+  assert(all.size() == og.nodes());
+  typename graph::shortest_paths paths;
+  int s = 0;
+  for(typename graph::const_iterator it = og.begin(); it != og.end(); it++, s++){
+    og.shortestPaths(*it, paths);
+    for(unsigned int j=0; j<all.size(); j++){
+      assert(all(s, j) == paths.distances()[j]);
+      assert(all.row(s)[j] == all(s, j));
+    }
+  }
+}
+
+void test_all_pairs(){
+  std::cout << "====== TEST_ALL_PAIRS ======" << std::endl;
+
+  //sizes around the tiles of 64 nodes
+  test_all_pairs_with<no_hash, dense_storage<int> >(150, 2, 1);
+  test_all_pairs_with<hash_int, sparse_storage<int> >(129, 1, 3);
+  test_all_pairs_with<hash_int, sparse_storage<double> >(100, 3, 2);
+  test_all_pairs_with<hash_int, bit_storage>(140, 2, 2);
+  test_all_pairs_with<hash_int, sparse_storage<long> >(64, 2, 0);
+
+  oriented_graph<int, equal_int> empty;
+  assert(empty.allPairsShortestPaths().size() == 0);
+
+  typedef oriented_graph<int, equal_int, hash_int, sparse_storage<int> > graph;
+  int nodes[] = {1, 2, 3};
+  graph og(nodes, 3);
+  og.addEdge(1, 2, 4);
+  og.addEdge(2, 3, -1);
+  try{
+    og.allPairsShortestPaths();
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+  og.removeEdge(2, 3);
+  graph::distance_matrix all = og.allPairsShortestPaths();
+  assert(all(0, 1) == 4 && all(1, 1) == 0);
+  assert(all(1, 0) == graph::distance_matrix::unreached);
+  graph::distance_matrix moved(std::move(all));
+  assert(moved.size() == 3 && all.size() == 0);
+}
+
+/**
+ * @brief a heavy label that counts its copies
+ */
+struct counted_label {
+  std::string text;
+  static int copies;
+
+  counted_label() {}
+  explicit counted_label(const std::string &t) : text(t) {}
+  counted_label(std::size_t n, char c) : text(n, c) {}
+  counted_label(const counted_label &other) : text(other.text) { copies++; }
+  counted_label(counted_label &&other) noexcept : text(std::move(other.text)) {}
+  counted_label& operator=(const counted_label &other){
+    text = other.text;
+    copies++;
+    return *this;
+  }
+  counted_label& operator=(counted_label &&other) noexcept {
+    text = std::move(other.text);
+    return *this;
+  }
+};
+
+int counted_label::copies = 0;
+
+struct equal_counted {
+  bool operator()(const counted_label &a, const counted_label &b) const {
+    return a.text == b.text;
+  }
+};
+
+struct hash_counted {
+  std::size_t operator()(const counted_label &a) const {
+    return std::hash<std::string>()(a.text);
+  }
+};
+
+void test_move(){
+  std::cout << "====== TEST_MOVE ======" << std::endl;
+
+  typedef oriented_graph<counted_label, equal_counted, hash_counted, sparse_storage<> > graph;
+  static_assert(std::is_nothrow_move_constructible<graph>::value, "graphs must move without throwing");
+  static_assert(std::is_nothrow_move_assignable<graph>::value, "graphs must move without throwing");
+
+  //moved and emplaced labels are never copied, also when the graph grows
+  counted_label::copies = 0;
+  graph og;
+  for(int i=0; i<100; i++){
+    counted_label label(std::string(100, 'a') + std::to_string(i));
+    og.addNode(std::move(label));
+  }
+  og.emplaceNode(200, 'b');
+  og.emplaceNode("short");
+  og.addEdge(counted_label("short"), counted_label(200, 'b'));
+  og.removeNode(counted_label(std::string(100, 'a') + "0"));
+  counted_label removed[] = {counted_label(std::string(100, 'a') + "1"), counted_label(std::string(100, 'a') + "2")};
+  og.removeNodes(removed, removed+2);
+  assert(counted_label::copies == 0);
+  assert(og.nodes() == 99 && og.edges() == 1);
+  try{
+    og.emplaceNode("short");
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+
+  //a failed insertion leaves the moved label untouched
+  counted_label duplicate("short");
+  try{
+    og.addNode(std::move(duplicate));
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+  assert(duplicate.text == "short");
+
+  //moving a graph takes its data, and leaves an empty graph
+  graph moved(std::move(og));
+  assert(counted_label::copies == 0);
+  assert(moved.nodes() == 99 && moved.edges() == 1);
+  assert(moved.existsEdge(counted_label("short"), counted_label(200, 'b')));
+  assert(og.nodes() == 0 && og.edges() == 0);
+  assert(!og.existsNode(counted_label("short")));
+  og.addNode(counted_label("again"));
+  assert(og.nodes() == 1);
+
+  og = std::move(moved);
+  assert(counted_label::copies == 0);
+  assert(og.nodes() == 99 && moved.nodes() == 0);
+  assert(og.existsNode(counted_label(200, 'b')) && !og.existsNode(counted_label("again")));
+
+  //a vector of graphs moves them when it grows
+  std::vector<graph> graphs;
+  for(int g=0; g<10; g++){
+    graphs.push_back(graph());
+    graphs.back().emplaceNode(std::to_string(g));
+  }
+  assert(counted_label::copies == 0);
+  assert(graphs[3].existsNode(counted_label("3")));
+}
+
+template <typename H, typename S>
+void test_node_ids_with(){
+  typedef oriented_graph<int, equal_int, H, S> graph;
+  graph og;
+  const int size = 50;
+  std::vector<typename graph::node_id> ids;
+  for(int i=0; i<size; i++)
+    ids.push_back(og.addNode(i * 3));
+  for(int i=0; i<size; i++){
+    assert(og.nodeId(i * 3) == ids[i]);
+    assert(og.label(ids[i]) == i * 3);
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j))
+        og.addEdge(ids[i], ids[j]);
+  }
+  for(int i=0; i<size; i++){
+    unsigned int out = 0, in = 0;
+    for(int j=0; j<size; j++){
+      assert(og.existsEdge(ids[i], ids[j]) == pattern_edge(i, j));
+      assert(og.existsEdge(i * 3, j * 3) == pattern_edge(i, j));
+      out += pattern_edge(i, j);
+      in += pattern_edge(j, i);
+    }
+    assert(og.outDegree(ids[i]) == out && og.inDegree(ids[i]) == in);
+    assert(og.outDegree(i * 3) == out && og.inDegree(i * 3) == in);
+  }
+
+  //the ids and the labels reach the same edges
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j) && (i + j) % 2 == 0)
+        og.removeEdge(ids[i], ids[j]);
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++)
+      assert(og.existsEdge(i * 3, j * 3) == (pattern_edge(i, j) && (i + j) % 2 == 1));
+  try{
+    og.removeEdge(ids[0], ids[0]);
+    assert(false);
+  }
+  catch(invalidEdgeException &e){}
+  if(og.existsEdge(ids[1], ids[2]))
+    try{
+      og.addEdge(ids[1], ids[2]);
+      assert(false);
+    }
+    catch(invalidEdgeException &e){}
+
+  //the id is the index of the node in the results of the algorithms
+  typename graph::shortest_paths paths = og.shortestPaths(3);
+  assert(paths.distances()[og.nodeId(3).index()] == 0);
+
+  //after a removal the ids must be resolved again
+  og.removeNode(0);
+  const typename graph::node_id moved = og.nodeId((size - 1) * 3);
+  assert(moved.index() == ids[0].index() && moved != ids[0]);
+  assert(og.label(moved) == (size - 1) * 3);
+
+  //the old ids are stale, even the ones of the nodes that did not move
+  assert(!og.existsEdge(ids[0], ids[0]) && !og.existsEdge(ids[1], ids[1]));
+  M_ASSERT_THROW(og.label(ids[0]), invalidNodeException);
+  M_ASSERT_THROW(og.label(ids[1]), invalidNodeException);
+  M_ASSERT_THROW(og.outDegree(ids[1]), invalidNodeException);
+  M_ASSERT_THROW(og.addEdge(ids[1], moved), invalidNodeException);
+  M_ASSERT_THROW(og.removeEdge(ids[1], ids[1]), invalidEdgeException);
+  assert(og.existsEdge(3, 18));
+  og.removeEdge(og.nodeId(3), og.nodeId(18));
+  assert(!og.existsEdge(3, 18));
+
+  //the ids of a copy are not valid on the original, the ids follow a swap
+  graph copy(og);
+  const typename graph::node_id copied = copy.nodeId(3);
+  assert(copy.label(copied) == 3);
+  M_ASSERT_THROW(og.label(copied), invalidNodeException);
+  copy.swap(og);
+  assert(og.label(copied) == 3);
+  M_ASSERT_THROW(copy.label(copied), invalidNodeException);
+  copy.swap(og);
+  assert(og.existsEdge(moved, og.nodeId(3)) == og.existsEdge((size - 1) * 3, 3));
+  typename graph::node_id none;
+  assert(!og.existsEdge(none, moved));
+  try{
+    og.addEdge(ids[size - 1], moved);
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+  try{
+    og.outDegree(none);
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+  try{
+    og.label(ids[size - 1]);
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+  try{
+    og.nodeId(0);
+    assert(false);
+  }
+  catch(invalidNodeException &e){}
+}
+
+void test_node_ids(){
+  std::cout << "====== TEST_NODE_IDS ======" << std::endl;
+
+  test_node_ids_with<no_hash, dense_storage<> >();
+  test_node_ids_with<hash_int, bit_storage>();
+  test_node_ids_with<hash_int, sparse_storage<> >();
+
+  //weighted edges, and emplaced nodes
+  oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<int> > og;
+  const oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<int> >::node_id
+    a = og.emplaceNode("a"), b = og.addNode(std::string("b"));
+  og.addEdge(a, b, 7);
+  assert(og.weight("a", "b") == 7);
+  assert(og.existsEdge(a, b) && !og.existsEdge(b, a));
+}
+
+
+template <typename H, typename S>
+void test_snapshot_with(const std::string &path){
+  typedef oriented_graph<int, equal_int, H, S> graph;
+  graph og;
+  const int size = 70;
+  for(int i=0; i<size; i++)
+    og.addNode(i * 5);
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j)){
+        if constexpr (std::is_same<typename S::weight_type, no_weight>::value)
+          og.addEdge(i * 5, j * 5);
+        else
+          og.addEdge(i * 5, j * 5, typename S::weight_type(i + j));
+      }
+  og.save(path);
+
+  for(int map=0; map<2; map++){
+    graph loaded = graph::load(path, map == 1);
+    assert(loaded.nodes() == og.nodes() && loaded.edges() == og.edges());
+    for(int i=0; i<size; i++){
+      assert(loaded.outDegree(i * 5) == og.outDegree(i * 5));
+      assert(loaded.inDegree(i * 5) == og.inDegree(i * 5));
+      for(int j=0; j<size; j++){
+        assert(loaded.existsEdge(i * 5, j * 5) == pattern_edge(i, j));
+        if constexpr (!std::is_same<typename S::weight_type, no_weight>::value)
+          if(pattern_edge(i, j))
+            assert(loaded.weight(i * 5, j * 5) == typename S::weight_type(i + j));
+      }
+    }
+
+    //the loaded graph is mutable, and the changes do not reach the file
+    loaded.removeEdge(0, 25);
+    loaded.addEdge(5, 0);
+    loaded.removeNode(10);
+    loaded.addNode(-1);
+    loaded.addEdge(-1, 0);
+    assert(loaded.existsEdge(5, 0) && !loaded.existsEdge(0, 25) && loaded.existsEdge(-1, 0));
+    assert(!loaded.existsNode(10));
+  }
+  graph reloaded = graph::load(path);
+  assert(reloaded.edges() == og.edges());
+  assert(reloaded.existsEdge(0, 25) && !reloaded.existsEdge(5, 0));
+  assert(reloaded.existsNode(10) && !reloaded.existsNode(-1));
+
+  //an empty graph
+  graph empty;
+  empty.save(path);
+  assert(graph::load(path).nodes() == 0);
+}
+
+void test_snapshot(){
+  std::cout << "====== TEST_SNAPSHOT ======" << std::endl;
+  const std::string path = "/tmp/ograph_test_snapshot.bin";
+
+  test_snapshot_with<no_hash, dense_storage<> >(path);
+  test_snapshot_with<hash_int, dense_storage<int> >(path);
+  test_snapshot_with<hash_int, bit_storage>(path);
+  test_snapshot_with<no_hash, sparse_storage<double> >(path);
+
+  //a mapped graph saved over its own file
+  typedef oriented_graph<int, equal_int, hash_int, bit_storage> bit_graph;
+  bit_graph chain;
+  for(int i=0; i<3000; i++)
+    chain.addNode(i);
+  for(int i=1; i<3000; i++)
+    chain.addEdge(i - 1, i);
+  chain.save(path);
+  bit_graph mapped = bit_graph::load(path);
+  mapped.addEdge(5, 7);
+  mapped.save(path);
+  assert(mapped.existsEdge(2998, 2999) && mapped.edges() == 3000);
+  bit_graph saved = bit_graph::load(path);
+  assert(saved.edges() == 3000 && saved.existsEdge(5, 7) && saved.existsEdge(2998, 2999));
+
+  //the acyclic mode is restored
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > dag;
+  dag.addNode(1);
+  dag.addNode(2);
+  dag.addEdge(1, 2);
+  dag.setAcyclic(true);
+  dag.save(path);
+  oriented_graph<int, equal_int, hash_int, sparse_storage<> > loaded_dag = oriented_graph<int, equal_int, hash_int, sparse_storage<> >::load(path);
+  assert(loaded_dag.acyclic());
+  try{
+    loaded_dag.addEdge(2, 1);
+    assert(false);
+  }
+  catch(cycleException &e){}
+
+  //labels that are not trivially copyable need a serializer
+  typedef oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, bit_storage> string_graph;
+  string_graph og;
+  og.addNode("first");
+  og.addNode("");
+  og.addNode(std::string(300, 'x'));
+  og.addEdge("first", "");
+  og.addEdge(std::string(300, 'x'), "first");
+  og.save(path, snapshot_string_labels());
+  string_graph loaded = string_graph::load(path, true, snapshot_string_labels());
+  assert(loaded.nodes() == 3 && loaded.edges() == 2);
+  assert(loaded.existsEdge("first", "") && loaded.existsEdge(std::string(300, 'x'), "first"));
+
+  //the file must match the types of the graph
+  try{
+    oriented_graph<int, equal_int, hash_int, bit_storage>::load(path);
+    assert(false);
+  }
+  catch(snapshotException &e){}
+  try{
+    oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, dense_storage<> >::load(path, true, snapshot_string_labels());
+    assert(false);
+  }
+  catch(snapshotException &e){}
+
+  //labels and weights of another type with the same size
+  typedef oriented_graph<int, equal_int, hash_int, dense_storage<int> > int_graph;
+  typedef oriented_graph<float, std::equal_to<float>, std::hash<float>, dense_storage<int> > float_label_graph;
+  typedef oriented_graph<int, equal_int, hash_int, dense_storage<float> > float_weight_graph;
+  int_graph typed;
+  typed.addNode(1);
+  typed.addNode(2);
+  typed.addEdge(1, 2, 5);
+  typed.addEdge(2, 1, 6);
+  typed.save(path);
+  M_ASSERT_THROW(float_label_graph::load(path), snapshotException);
+  M_ASSERT_THROW(float_weight_graph::load(path), snapshotException);
+  float_weight_graph floats;
+  floats.addNode(1);
+  floats.addNode(2);
+  floats.addEdge(1, 2, 0.5f);
+  floats.save(path);
+  assert(float_weight_graph::load(path).weight(1, 2) == 0.5f);
+  M_ASSERT_THROW(int_graph::load(path), snapshotException);
+
+  //corrupted counters and flags are load errors
+  typed.save(path);
+  snapshot_header header;
+  {
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  }
+  const unsigned int wrong_degree = 2;
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(header.degrees_offset);
+    file.write(reinterpret_cast<const char*>(&wrong_degree), sizeof(wrong_degree));
+  }
+  for(int map=0; map<2; map++)
+    M_ASSERT_THROW(int_graph::load(path, map == 1), snapshotException);
+  typed.save(path);
+  header.flags = snapshot_acyclic;
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+  M_ASSERT_THROW(int_graph::load(path), snapshotException);
+  typed.save(path);
+  header.flags = 0;
+  header.edges = 3;
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+  M_ASSERT_THROW(int_graph::load(path), snapshotException);
+
+  //sizes in the header that do not fit the file are load errors, not allocations
+  typed.save(path);
+  header.edges = 2;
+  header.nodes = 0xFFFFFFFF;
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+  M_ASSERT_THROW(int_graph::load(path), snapshotException);
+  typed.save(path);
+  header.nodes = 2;
+  header.degrees_offset = 0xFFFFFFFFFFFFFFF0u;
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+  M_ASSERT_THROW(int_graph::load(path), snapshotException);
+  typedef oriented_graph<int, equal_int, hash_int, sparse_storage<int> > sparse_graph;
+  sparse_graph sparse;
+  sparse.addNode(1);
+  sparse.addNode(2);
+  sparse.addEdge(1, 2, 5);
+  sparse.save(path);
+  {
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  }
+  header.edges = 0x4000000000000001u;
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+  M_ASSERT_THROW(sparse_graph::load(path), snapshotException);
+
+  //cells past the nodes and padding cells of the adjacency are load errors
+  typedef oriented_graph<int, equal_int, hash_int, bit_storage> small_bit_graph;
+  small_bit_graph bits;
+  for(int i=0; i<3; i++)
+    bits.addNode(i);
+  bits.addEdge(0, 1);
+  const std::uint64_t past_nodes = std::uint64_t(1) << 40;
+  bits.save(path);
+  {
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  }
+  for(std::uint64_t offset=0; offset<2; offset++){
+    bits.save(path);
+    {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(header.adjacency_offset + offset * sizeof(past_nodes));
+      file.write(reinterpret_cast<const char*>(&past_nodes), sizeof(past_nodes));
+    }
+    for(int map=0; map<2; map++)
+      M_ASSERT_THROW(small_bit_graph::load(path, map == 1), snapshotException);
+  }
+  int_graph cells;
+  cells.addNode(1);
+  cells.addNode(2);
+  cells.addEdge(1, 2, 3);
+  cells.save(path);
+  {
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  }
+  const int wrong_cell = 2;
+  for(std::uint64_t cell=0; cell<3; cell+=2){
+    cells.save(path);
+    {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(header.adjacency_offset + cell * sizeof(wrong_cell));
+      file.write(reinterpret_cast<const char*>(&wrong_cell), sizeof(wrong_cell));
+    }
+    for(int map=0; map<2; map++)
+      M_ASSERT_THROW(int_graph::load(path, map == 1), snapshotException);
+  }
+
+  //string lengths past the label section, or that do not fill it
+  const std::uint32_t first_length = 0xFFFFFFF0u, last_length = 299;
+  const std::uint64_t last_label = sizeof(header) + 4 + 5 + 4;
+  for(int last=0; last<2; last++){
+    og.save(path, snapshot_string_labels());
+    {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(last ? last_label : sizeof(header));
+      file.write(reinterpret_cast<const char*>(last ? &last_length : &first_length), sizeof(std::uint32_t));
+    }
+    M_ASSERT_THROW(string_graph::load(path, true, snapshot_string_labels()), snapshotException);
+  }
+
+  std::remove(path.c_str());
+  try{
+    string_graph::load(path, true, snapshot_string_labels());
+    assert(false);
+  }
+  catch(snapshotException &e){}
+  try{
+    og.save("/nonexistent/ograph.bin", snapshot_string_labels());
+    assert(false);
+  }
+  catch(const std::exception &e){
+    //the message is reachable from the base class
+    assert(std::string(e.what()) == "Invalid snapshot");
+  }
+}
+
+
+template <typename H, typename S>
+void test_edge_list_with(unsigned threads, std::size_t chunk){
+  typedef oriented_graph<int, equal_int, H, S> graph;
+  const int size = 60;
+  std::string text = "# comment line\n\n";
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j)){
+        text += std::to_string(i * 3) + ((i + j) % 2 ? "\t" : "  ") + std::to_string(j * 3);
+        if((i + j) % 3 == 0)
+          text += " " + std::to_string(i + j);
+        text += (i % 4 == 0 ? " \r\n" : "\n");
+      }
+  //the last line has no end of line
+  text += "-1 0";
+
+  std::istringstream in(text);
+  const graph og = graph::readEdgeList(in, threads, edge_list_labels<int>(), chunk);
+  assert(og.nodes() == size + 1);
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++){
+      assert(og.existsEdge(i * 3, j * 3) == pattern_edge(i, j));
+      if constexpr (!std::is_same<typename S::weight_type, no_weight>::value)
+        if(pattern_edge(i, j))
+          assert(og.weight(i * 3, j * 3) == ((i + j) % 3 == 0 ? i + j : 1));
+    }
+  assert(og.existsEdge(-1, 0) && og.inDegree(0) == og.outDegree(0) + 1);
+
+  //the positions follow the first appearance of the labels
+  typename graph::const_iterator node = og.begin();
+  assert(*node == 0 && *++node == 15);
+}
+
+void test_edge_list(){
+  std::cout << "====== TEST_EDGE_LIST ======" << std::endl;
+
+  test_edge_list_with<hash_int, sparse_storage<> >(1, edge_list_chunk);
+  test_edge_list_with<hash_int, sparse_storage<int> >(3, 5);
+  test_edge_list_with<no_hash, dense_storage<int> >(2, 64);
+  test_edge_list_with<hash_int, bit_storage>(4, 1);
+
+  typedef oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<double> > string_graph;
+  std::istringstream in("rome paris 1.5\nparis berlin\nberlin rome 0.25\nrome berlin -2e1\n");
+  const string_graph og = string_graph::readEdgeList(in, 2, edge_list_string_labels(), 16);
+  assert(og.nodes() == 3 && og.edges() == 4);
+  assert(og.weight("rome", "paris") == 1.5 && og.weight("paris", "berlin") == 1.0);
+  assert(og.weight("berlin", "rome") == 0.25 && og.weight("rome", "berlin") == -20.0);
+
+  std::istringstream empty("");
+  assert(string_graph::readEdgeList(empty, 1, edge_list_string_labels()).nodes() == 0);
+
+  //lines that are not valid, and duplicate edges
+  const char* invalid[] = {"1 2\n3\n", "1 2 3 4\n", "1 x\n", "1 2 3.5\n", "1 2\n1 2\n"};
+  for(int c=0; c<5; c++){
+    std::istringstream bad(invalid[c]);
+    try{
+      oriented_graph<int, equal_int, hash_int, sparse_storage<int> >::readEdgeList(bad, 2, edge_list_labels<int>(), 3);
+      assert(false);
+    }
+    catch(edgeListException &e){
+      assert(c < 4);
+    }
+    catch(invalidEdgeException &e){
+      assert(c == 4);
+    }
+  }
+}
+
+
+template <typename S>
+void test_export_with(){
+  typedef oriented_graph<int, equal_int, hash_int, S> graph;
+  graph og;
+  const int size = 40;
+  for(int i=0; i<size; i++)
+    og.addNode(i * 2);
+  og.addNode(-7);
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++)
+      if(pattern_edge(i, j)){
+        if constexpr (std::is_same<typename S::weight_type, no_weight>::value)
+          og.addEdge(i * 2, j * 2);
+        else
+          og.addEdge(i * 2, j * 2, typename S::weight_type(i - j));
+      }
+
+  //the matrix has the layout of the old print
+  std::ostringstream matrix;
+  og.writeMatrix(matrix);
+  std::string expected;
+  for(int i=0; i<=size; i++){
+    for(int j=0; j<=size; j++)
+      expected += (i < size && j < size && pattern_edge(i, j)) ? "1 " : "0 ";
+    expected += "\n";
+  }
+  assert(matrix.str() == expected);
+
+  //the edge list reads back to the same edges
+  std::ostringstream list;
+  og.writeEdgeList(list);
+  std::istringstream in(list.str());
+  const graph loaded = graph::readEdgeList(in, 1);
+  assert(loaded.edges() == og.edges());
+  assert(loaded.nodes() == og.nodes() - 1 && !loaded.existsNode(-7));
+  for(int i=0; i<size; i++)
+    for(int j=0; j<size; j++){
+      assert(loaded.existsEdge(i * 2, j * 2) == pattern_edge(i, j));
+      if constexpr (!std::is_same<typename S::weight_type, no_weight>::value)
+        if(pattern_edge(i, j))
+          assert(loaded.weight(i * 2, j * 2) == og.weight(i * 2, j * 2));
+    }
+
+  //one DOT statement per node and per edge
+  std::ostringstream dot;
+  og.writeDot(dot);
+  const std::string text = dot.str();
+  assert(text.compare(0, 10, "digraph {\n") == 0);
+  assert(text.find("  40 [label=\"-7\"];\n") != std::string::npos);
+  assert(text.find(std::is_same<typename S::weight_type, no_weight>::value ? "  1 -> 6;\n" : "  1 -> 6 [label=\"-5\"];\n") != std::string::npos);
+  std::size_t statements = 0;
+  for(std::size_t c=0; c<text.size(); c++)
+    statements += text[c] == ';';
+  assert(statements == og.nodes() + og.edges());
+}
+
+void test_export(){
+  std::cout << "====== TEST_EXPORT ======" << std::endl;
+
+  test_export_with<dense_storage<> >();
+  test_export_with<bit_storage>();
+  test_export_with<sparse_storage<int> >();
+  test_export_with<sparse_storage<double> >();
+
+  //string labels, escaped in DOT
+  oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<> > og;
+  og.addNode("say \"hi\"");
+  og.addNode("back\\slash");
+  og.addEdge("say \"hi\"", "back\\slash");
+  std::ostringstream dot;
+  og.writeDot(dot, edge_list_string_labels());
+  assert(dot.str() == "digraph {\n  0 [label=\"say \\\"hi\\\"\"];\n  1 [label=\"back\\\\slash\"];\n  0 -> 1;\n}\n");
+
+  //a file descriptor
+  std::FILE* file = std::tmpfile();
+  assert(file != nullptr);
+  og.writeEdgeList(fileno(file), edge_list_string_labels());
+  std::rewind(file);
+  char line[64] = {0};
+  assert(std::fgets(line, sizeof(line), file) != nullptr);
+  assert(std::string(line) == "say\\s\"hi\" back\\\\slash\n");
+  std::fclose(file);
+
+  //the labels that would split or hide a field read back the same
+  const std::string odd[] = {"say \"hi\"", "back\\slash", "", "#hash", "a#b", "tab\there", "two\nlines\r", " ", "\\s"};
+  oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<int> > labelled;
+  for(int l=0; l<9; l++)
+    labelled.addNode(odd[l]);
+  for(int l=0; l<9; l++)
+    labelled.addEdge(odd[l], odd[(l + 1) % 9], l);
+  std::ostringstream list;
+  labelled.writeEdgeList(list, edge_list_string_labels());
+  std::istringstream in(list.str());
+  const oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<int> > read =
+    oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<int> >::readEdgeList(in, 1, edge_list_string_labels());
+  assert(read.nodes() == 9 && read.edges() == 9);
+  for(int l=0; l<9; l++)
+    assert(read.existsEdge(odd[l], odd[(l + 1) % 9]) && read.weight(odd[l], odd[(l + 1) % 9]) == l);
+  std::istringstream bad_escape("a\\x b\n");
+  try{
+    oriented_graph<std::string, std::equal_to<std::string>, std::hash<std::string>, sparse_storage<int> >::readEdgeList(bad_escape, 1, edge_list_string_labels());
+    assert(false);
+  }
+  catch(const std::exception &e){
+    //the message is reachable from the base class
+    assert(std::string(e.what()) == "Invalid edge list");
+  }
+
+  //an empty graph, and outputs that fail
+  oriented_graph<int, equal_int, hash_int, bit_storage> empty;
+  std::ostringstream nothing;
+  empty.writeMatrix(nothing);
+  assert(nothing.str().empty());
+  std::ostringstream failed;
+  failed.setstate(std::ios::badbit);
+  try{
+    og.writeMatrix(failed);
+    assert(false);
+  }
+  catch(exportException &e){}
+  try{
+    og.writeDot(-1, edge_list_string_labels());
+    assert(false);
+  }
+  catch(const std::exception &e){
+    //the message is reachable from the base class
+    assert(std::string(e.what()) == "Export failed");
+  }
+}
+
 
 int main(){
   test_custom_class();
@@ -589,4 +3160,29 @@ int main(){
   test_copy_constructor();
   test_copy_assignment();
   test_iterator();
+  test_hash_index();
+  test_capacity();
+  test_matrix_layout();
+  test_storage_policy();
+  test_sparse_storage();
+  test_bulk_constructor();
+  test_batch_mutators();
+  test_node_removal();
+  test_degrees();
+  test_simd_kernels();
+  test_neighbors();
+  test_edge_iterator();
+  test_traversal();
+  test_parallel_bfs();
+  test_transitive_closure();
+  test_components();
+  test_acyclic();
+  test_weights();
+  test_shortest_paths();
+  test_all_pairs();
+  test_move();
+  test_node_ids();
+  test_snapshot();
+  test_edge_list();
+  test_export();
 }
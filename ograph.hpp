@@ -8,10 +8,24 @@
 #define OGRAPH_HPP
 
 #include <algorithm> // std::swap
+#include <atomic>    // std::atomic
 #include <iostream>  // std::ostream
-#include <iterator>  // std::forward_iterator_tag
+#include <iterator>  // std::forward_iterator_tag, std::input_iterator_tag
+#include <limits>    // std::numeric_limits
 #include <cstddef>   // std::ptrdiff_t
+#include <cstdint>   // std::uint64_t
+#include <cstdio>    // std::rename
+#include <cstring>   // std::memcmp
 #include <exception> // std::exception
+#include <fstream>   // std::ifstream
+#include <string>    // std::string
+#include <type_traits> // std::is_same
+#include <utility>   // std::pair
+#include <vector>    // std::vector
+#include "ograph_storage.hpp"
+#include "ograph_parallel.hpp"
+#include "ograph_snapshot.hpp"
+#include "ograph_edgelist.hpp"
 
 /**
  * @brief The node provided is not valid
@@ -35,6 +49,99 @@ class invalidEdgeException: public std::exception {
   }
 };
 
+/**
+ * @brief The operation would make a cycle in a graph that must be acyclic
+ *
+ * The edge closes a cycle, or the graph already has one
+ */
+class cycleException: public invalidEdgeException {
+  public:
+    const char* what() const noexcept override {
+      return "Cycle in the graph";
+    }
+};
+
+/**
+ * @brief The snapshot file could not be written or read
+ *
+ * The file is missing or truncated, or was saved by a graph of another type
+ */
+class snapshotException: public std::exception {
+  public:
+    const char* what() const noexcept override {
+      return "Invalid snapshot";
+    }
+};
+
+/**
+ * @brief The edge list has a line that is not valid
+ *
+ * A line has a single field or more than three, or a label or a weight could not be parsed
+ */
+class edgeListException: public std::exception {
+  public:
+    const char* what() const noexcept override {
+      return "Invalid edge list";
+    }
+};
+
+/**
+ * @brief The export could not be written
+ *
+ * The stream or the file descriptor rejected the output
+ */
+class exportException: public std::exception {
+  public:
+    const char* what() const noexcept override {
+      return "Export failed";
+    }
+};
+
+/**
+ * @brief default hash policy for the oriented graph
+ *
+ * Disables the hash index: node lookups fall back to a linear
+ * scan of the nodes, using the E functor.
+ */
+struct no_hash {};
+
+/**
+ * @brief equality functor for graphs labelled by integer ids,
+ * like the condensation graph
+ *
+ */
+struct id_equal {
+  bool operator()(unsigned int a, unsigned int b) const {
+    return a == b;
+  }
+};
+
+/**
+ * @brief hash functor for graphs labelled by integer ids
+ *
+ */
+struct id_hash {
+  std::size_t operator()(unsigned int a) const {
+    return a;
+  }
+};
+
+/**
+ * @brief type of the path lengths for a weight type W
+ *
+ * The integer weights are summed in 64 bits, so a path of many narrow
+ * weights does not overflow. The other weight types keep their type.
+ */
+template <typename W, bool = std::is_integral<W>::value>
+struct path_length {
+  typedef W type;
+};
+
+template <typename W>
+struct path_length<W, true> {
+  typedef typename std::common_type<W, long long>::type type;
+};
+
 /**
  * @brief an oriented graph
  *
@@ -43,15 +150,226 @@ class invalidEdgeException: public std::exception {
  * Each label is unique. There cannot be two nodes that are equal,
  *   equality is checked using the provided E functor.
  *
+ * When a hash functor H is provided, the graph keeps a hash index
+ * from labels to node positions, and lookups are O(1) on average.
+ * H must be consistent with E: labels that are equal according to E
+ * must have the same hash.
+ *
+ * The edges are kept by the storage policy S, see ograph_storage.hpp.
+ * dense_storage uses an integer matrix, bit_storage a bit-packed matrix,
+ * sparse_storage sorted adjacency lists, for graphs with few edges per node.
+ * dense_storage<W> and sparse_storage<W> keep a weight of type W
+ * for every edge; bit_storage, the default, has no weights.
+ *
  * @tparam T type for the node labels
  * @tparam E functor used for node comparison
+ * @tparam H functor used for node hashing, or no_hash for linear lookups
+ * @tparam S storage policy for the edges
  */
-template <typename T, typename E>
+template <typename T, typename E, typename H = no_hash, typename S = bit_storage>
 class oriented_graph {
   //traits
   public:
     typedef unsigned int size_type;
     typedef T value_type;
+    typedef typename S::weight_type weight_type;
+
+    /**
+     * @brief handle of a node, for the calls that skip the label lookup
+     *
+     * A node_id holds the position of the node in the graph, the same
+     * index used by const_iterator order and by the results of the
+     * shortest paths, and the epoch of the graph that issued it.
+     * It is valid until a node is removed from the graph: removeNode
+     * moves the last node in the freed position, and removeNodes
+     * renumbers the nodes, so both start a new epoch. The calls that
+     * take an id throw on the ids of an older epoch, or of another graph,
+     * instead of reaching the node that took the position.
+     */
+    class node_id {
+      public:
+        /**
+         * @brief an id that refers to no node
+         */
+        node_id() : _position(static_cast<size_type>(-1)), _epoch(0) {}
+
+        /**
+         * @brief the position of the node
+         */
+        size_type index() const{
+          return _position;
+        }
+
+        bool operator==(const node_id &other) const{
+          return _position == other._position && _epoch == other._epoch;
+        }
+
+        bool operator!=(const node_id &other) const{
+          return !(*this == other);
+        }
+
+      private:
+        friend class oriented_graph;
+        node_id(size_type position, std::uint64_t epoch) : _position(position), _epoch(epoch) {}
+        size_type _position;
+        std::uint64_t _epoch;
+    };
+
+    /**
+     * @brief type of the path lengths: the amount of edges when the storage
+     *   has no weights, long long or unsigned long long for the integer
+     *   weights, the weight type otherwise. See path_length
+     *
+     */
+    typedef typename std::conditional<std::is_same<weight_type, no_weight>::value,
+      size_type, typename path_length<weight_type>::type>::type distance_type;
+
+    /**
+     * @brief the result of shortestPaths(), and the buffers of the search
+     *
+     * The distances and the parents are indexed like the nodes in
+     * const_iterator order. Reusing the same instance for many queries
+     * on graphs of the same size allocates no memory.
+     */
+    class shortest_paths {
+      public:
+        /**
+         * @brief parent of the source and of the unreached nodes
+         *
+         */
+        static constexpr size_type none = static_cast<size_type>(-1);
+
+        /**
+         * @brief distance of the unreached nodes
+         *
+         */
+        static constexpr distance_type unreached = std::numeric_limits<distance_type>::max();
+
+        /**
+         * @brief the length of the shortest path from the source to every node
+         *
+         */
+        const std::vector<distance_type>& distances() const{
+          return _distance;
+        }
+
+        /**
+         * @brief the node before every node on its shortest path
+         *
+         */
+        const std::vector<size_type>& parents() const{
+          return _parent;
+        }
+
+        /**
+         * @brief check if the node of index i has a path from the source
+         */
+        bool reached(size_type i) const{
+          return _distance[i] != unreached;
+        }
+
+      private:
+        friend class oriented_graph;
+        std::vector<distance_type> _distance;
+        std::vector<size_type> _parent;
+
+        /**
+         * @brief the queue of the breadth first search, or the d-ary heap
+         *
+         */
+        std::vector<size_type> _queue;
+
+        /**
+         * @brief the position of every node in the heap, or none
+         *
+         */
+        std::vector<size_type> _slot;
+
+        /**
+         * @brief the buckets of the radix heap, as (distance, node) pairs
+         *
+         * Bucket b holds the distances that first differ from the last
+         * extracted one in bit b-1. They keep their capacity between queries.
+         */
+        std::vector<std::pair<std::uint64_t, size_type> > _radix[65];
+
+        /**
+         * @brief size the buffers for n nodes, and mark all the nodes unreached
+         *
+         * @throw std::bad_alloc
+         */
+        void _reset(size_type n){
+          _distance.assign(n, unreached);
+          _parent.assign(n, none);
+          _queue.resize(n);
+          _slot.assign(n, none);
+        }
+    };
+
+    /**
+     * @brief the result of allPairsShortestPaths()
+     *
+     * A square matrix of distances, with the rows and the columns
+     * indexed like the nodes in const_iterator order. Each row starts
+     * on its own cache line.
+     */
+    class distance_matrix {
+      public:
+        /**
+         * @brief distance of the pairs without a path
+         *
+         */
+        static constexpr distance_type unreached = shortest_paths::unreached;
+
+        distance_matrix() : _cells(nullptr), _size(0), _stride(0) {}
+
+        ~distance_matrix(){
+          storage_delete_cells(_cells);
+        }
+
+        distance_matrix(distance_matrix &&other) : _cells(other._cells), _size(other._size), _stride(other._stride) {
+          other._cells = nullptr;
+          other._size = 0;
+          other._stride = 0;
+        }
+
+        distance_matrix& operator=(distance_matrix &&other){
+          std::swap(_cells, other._cells);
+          std::swap(_size, other._size);
+          std::swap(_stride, other._stride);
+          return *this;
+        }
+
+        distance_matrix(const distance_matrix &other) = delete;
+        distance_matrix& operator=(const distance_matrix &other) = delete;
+
+        /**
+         * @brief the amount of nodes
+         */
+        size_type size() const{
+          return _size;
+        }
+
+        /**
+         * @brief the length of the shortest path from node i to node j
+         */
+        distance_type operator()(size_type i, size_type j) const{
+          return _cells[i * _stride + j];
+        }
+
+        /**
+         * @brief the distances from node i, size() values
+         */
+        const distance_type* row(size_type i) const{
+          return _cells + i * _stride;
+        }
+
+      private:
+        friend class oriented_graph;
+        distance_type* _cells;
+        size_type _size;
+        std::size_t _stride;
+    };
 
   //internal attributes
   private:
@@ -62,267 +380,2090 @@ class oriented_graph {
      */
     size_type _size;
 
+    /**
+     * @brief the amount of nodes the graph can hold without reallocating
+     *
+     */
+    size_type _capacity;
+
     /**
      * @brief an indexed list of all nodes
      *
      * the index of a node in this list will be used
-     * as key in the adjacency matrix
+     * as key in the adjacency matrix.
+     * Only the first _size elements are part of the graph,
+     * the array has room for _capacity elements
      *
      */
     T* _nodes;
 
     /**
-     * @brief adjacency matrix for the graph
+     * @brief adjacency data for the graph
+     *
+     * Has room for _capacity nodes, the positions
+     * of the nodes are the same as in _nodes
      *
      */
-    int** _matrix;
+    S _storage;
 
     /**
-     * @brief functor for the equality check between data of type T
+     * @brief the amount of edges in the graph
      *
      */
-    E _eql;
+    std::size_t _edges;
 
-  //internal utilities
-  private:
+    /**
+     * @brief the amount of edges leaving each node
+     *
+     * Has room for _capacity nodes, the entries past _size are 0
+     *
+     */
+    size_type* _out_degree;
 
     /**
-     * @brief delete the dynamic memory of a matrix
+     * @brief the amount of edges entering each node
+     *
+     * Has room for _capacity nodes, the entries past _size are 0
      *
-     * @param matrix the matrix to delete
-     * @param size the matrix size
      */
-    void _delete_matrix(int **matrix, size_type size){
-      if(matrix != nullptr)
-        for(size_type i=0; i<size; i++)
-          delete[] matrix[i];
-      delete[] matrix;
-    }
+    size_type* _in_degree;
 
     /**
-     * @brief initialize all the rows of a matrix to nullptrs
+     * @brief true when the graph rejects the edges that close a cycle
      *
-     * call this when initializing a matrix, between the initialization
-     * of the rows and the initialization of the columns.
-     * The purpose of this method is to allow _delete_matrix to work
-     * in the case of allocation errors on the columns
+     */
+    bool _acyclic;
+
+    /**
+     * @brief the epoch of the node positions, see node_id
      *
-     * Do not call this method on a fully initialized matrix
-     * (This warning is the telltale sign that matrix should have been implemented in a standalone class)
+     * Taken from a counter shared by all the graphs, so no two graphs
+     * and no two layouts of the same graph have the same epoch.
+     * Follows the nodes in swap and in the moves.
      *
-     * @param matrix a matrix where only the rows have been allocated
-     * @param size
      */
-    void _init_matrix(int **matrix, size_type size){
-      if(matrix != nullptr)
-        for(size_type i=0; i<size; i++)
-          matrix[i] = nullptr;
-    }
+    std::uint64_t _epoch = _new_epoch();
 
     /**
-     * @brief delete all the internal data of the graph
+     * @brief a new epoch, never returned before
      *
-     * @post _size = 0
-     * @post _nodes = nullptr
-     * @post _matrix = nullptr
      */
-    void _clear(){
-      delete[] _nodes;
-      _delete_matrix(_matrix, _size);
-      _nodes = nullptr;
-      _matrix = nullptr;
-      _size = 0;
+    static std::uint64_t _new_epoch(){
+      static std::atomic<std::uint64_t> counter(1);
+      return counter.fetch_add(1, std::memory_order_relaxed);
     }
 
     /**
-     * @brief find the index position of a node in the _nodes list
+     * @brief the rank of every node in a topological order
+     *
+     * Kept only in acyclic mode, see setAcyclic. Has _size elements
      *
-     * @param node the node to search
-     * @return the index position of the given node in _nodes
      */
-    int _index(const T &node) const{
-      for(size_type i=0; i<_size; i++)
-        if(_eql(_nodes[i], node))
-          return i;
-      return -1;
-    }
+    std::vector<size_type> _rank;
 
-  //special members
-  public:
+    /**
+     * @brief the position of the node of every rank, the inverse of _rank
+     *
+     */
+    std::vector<size_type> _ranked;
 
     /**
-     * @brief Default constructor
+     * @brief marks of the nodes visited by _order_edge, all 0 between calls
      *
-     * @post _size = 0
-     * @post _nodes = nullptr
-     * @post _matrix = nullptr
-    */
-    oriented_graph() : _size(0), _nodes(nullptr), _matrix(nullptr) {
-      #ifndef NDEBUG 
-      std::cout<<"oriented_graph()"<<std::endl;
-      #endif
-    }
+     */
+    std::vector<unsigned char> _mark;
 
     /**
-     * @brief Secondary constructor
+     * @brief open addressing hash table of node indexes
      *
-     * @param nodes a list of nodes that are part of the graph
-     * @param size the nodes list size
+     * each bucket contains the position in _nodes of a node,
+     * or _empty_bucket. Unused when H is no_hash
      *
-     * @throw std::bad_alloc 
-     * @throw invalidNodeException there are duplicate nodes in the provided nodes list
-     * @post _size = size
-     * @post _nodes != nullptr
-     * @post _matrix != nullptr
      */
-    oriented_graph(const T* const nodes, const size_type size) : _size(0), _nodes(nullptr), _matrix(nullptr) {
-      #ifndef NDEBUG 
-      std::cout<<"oriented_graph(nodes, size)"<<std::endl;
-      #endif
-
-      try{
-        for(size_type i=0; i<size; i++){
-          addNode(nodes[i]);
-        }
-      }
-      catch(...){
-        #ifndef NDEBUG 
-        std::cout<<"exception in oriented_graph(nodes, size)"<<std::endl;
-        #endif   
-        //objects that throw exceptions in the constructors are considered not initialized
-        //therefore their destructor will not be called in the stack unwind mechanism.
-        //we must free the content ourselves to avoid memory leaks.
-        _clear();
-        throw;
-      }
-    }
+    size_type* _buckets;
 
     /**
-     * @brief Destructor
+     * @brief the amount of buckets in the hash table, always a power of two
      *
-     * @post _size = 0
-     * @post _nodes = nullptr
-     * @post _matrix = nullptr
      */
-    ~oriented_graph(){
-      _clear();
-      #ifndef NDEBUG 
-      std::cout<<"~oriented_graph()"<<std::endl;
-      #endif   
-    }
+    size_type _bucket_count;
 
     /**
-     * @brief swap the state of the current instance with the given instance
+     * @brief functor for the equality check between data of type T
      *
-     * @param other the instance to swap with
-     * @post _size != _size
-     * @post _nodes != _nodes
-     * @post _matrix != _matrix
      */
-    void swap(oriented_graph &other) {
-      std::swap(_size,other._size);
-      std::swap(_nodes,other._nodes);
-      std::swap(_matrix,other._matrix);
-    }
+    E _eql;
 
     /**
-     * @brief copy constructor
+     * @brief functor for the hashing of data of type T
      *
-     * @param other object to copy
-     * @throw std::bad_alloc 
-     * @post _size = size
-     * @post _nodes != nullptr
-     * @post _matrix != nullptr
      */
-    oriented_graph(const oriented_graph &other): _size(0), _nodes(nullptr), _matrix(nullptr) {
-      #ifndef NDEBUG 
-      std::cout<<"oriented_graph(&oriented_graph)"<<std::endl;
-      #endif   
-      //copy without edges
-      for(size_type i=0; i<other._size; i++){
-        addNode(other._nodes[i]);
-      }
-      //copy edges
-      for(size_type i=0; i<other._size; i++)
-        for(size_type j=0; j<other._size; j++)
-          _matrix[i][j] = other._matrix[i][j];
-    }
+    H _hash;
 
     /**
-     * @brief copy assignment
+     * @brief true when the graph maintains a hash index
      *
-     * @param other the element to copy
-     * @return reference to current graph, post-copy
-     * @throw std::bad_alloc 
-     * @post _size != _size
-     * @post _nodes != _nodes
-     * @post _matrix != _matrix
      */
-    oriented_graph& operator=(const oriented_graph &other){
-      if (&other != this) {
-        oriented_graph tmp(other);
-        this->swap(tmp); 
-      }
-      return *this;
-    }
+    static constexpr bool _hashed = !std::is_same<H, no_hash>::value;
 
-  //public interface
-  public:
+    /**
+     * @brief true when the storage keeps a weight for every edge
+     *
+     */
+    static constexpr bool _weighted = !std::is_same<weight_type, no_weight>::value;
 
     /**
-     * @brief graph nodes size getter
+     * @brief the weight of the edges added without an explicit weight
      *
-     * @return the amount of nodes in the graph
+     * @return 1 when the weight type can be built from an int, a default weight otherwise
      */
-    size_type nodes() const{
-      return _size;
+    static weight_type _unit_weight(){
+      if constexpr (std::is_constructible<weight_type, int>::value)
+        return weight_type(1);
+      else
+        return weight_type();
     }
 
     /**
-     * @brief graph edges size getter
+     * @brief marker for an unused bucket in the hash table
      *
-     * @return the amount of edges in the graph
      */
-    int edges() const{
-      int count = 0;
+    static constexpr size_type _empty_bucket = static_cast<size_type>(-1);
 
-      for(size_type i=0; i<_size; i++)
-        for(size_type j=0; j<_size; j++)
-          count += _matrix[i][j];
+  //internal utilities
+  private:
 
-      return count;
+    /**
+     * @brief delete all the internal data of the graph
+     *
+     * The hash table is not part of the data deleted by this method,
+     * since it's reused across insertions. see _clear_index
+     *
+     * @post _size = 0
+     * @post _capacity = 0
+     * @post _nodes = nullptr
+     * @post _edges = 0
+     */
+    void _clear(){
+      delete[] _nodes;
+      delete[] _out_degree;
+      delete[] _in_degree;
+      S empty;
+      _storage.swap(empty);
+      _nodes = nullptr;
+      _out_degree = nullptr;
+      _in_degree = nullptr;
+      _size = 0;
+      _capacity = 0;
+      _edges = 0;
     }
 
     /**
-     * @brief print the graph edges to stdout
+     * @brief allocate a zeroed degree counter array
      *
+     * @param capacity the amount of nodes
+     * @throw std::bad_alloc
      */
-    void print() const{
-      for(size_type i=0; i<_size; i++){
-        for(size_type j=0; j<_size; j++){
-          std::cout << _matrix[i][j] << " ";
-        }
-        std::cout << std::endl;
-      }
+    static size_type* _new_degrees(size_type capacity){
+      if(capacity == 0)
+        return nullptr;
+      return new size_type[capacity]();
     }
 
     /**
-     * @brief check if a node is part of the graph
+     * @brief recompute the degree counters from the storage
      *
-     * @returns true the node exists
-     * @returns false the node does not exist
+     * @param old_size the amount of counters that may be non-zero
+     * @post _edges = the amount of edges in the storage
      */
-    bool existsNode(const T &node) const{
-      return (_index(node) != -1);
+    void _recount(size_type old_size){
+      _storage.degrees(_size, _out_degree, _in_degree);
+      std::fill(_out_degree+_size, _out_degree+old_size, 0);
+      std::fill(_in_degree+_size, _in_degree+old_size, 0);
+      _edges = 0;
+      for(size_type i=0; i<_size; i++)
+        _edges += _out_degree[i];
     }
 
     /**
-     * @brief check if an edge is part of the graph
+     * @brief move a label when that cannot throw, copy it otherwise
      *
-     * This implementation considers invalid nodes to be a valid query,
-     * therefore providing an invalid node will not raies any exception
-     *  
-     * @param nodeFrom the start node
+     * The callers roll back when a copy throws, and the source
+     * labels must still be intact to do so.
+     */
+    static void _transfer(T &to, T &from){
+      if constexpr (std::is_nothrow_move_assignable<T>::value)
+        to = std::move(from);
+      else
+        to = from;
+    }
+
+    /**
+     * @brief move the graph into new data structures of the given capacity
+     *
+     * Provides the strong exception guarantee: if an allocation or a copy
+     * of a node throws, the graph is left untouched. The nodes are moved
+     * when their move assignment cannot throw.
+     *
+     * @param new_capacity the new capacity, not smaller than _size
+     * @throw std::bad_alloc
+     * @post _capacity = new_capacity
+     * @post _nodes != _nodes
+     */
+    void _reallocate(size_type new_capacity){
+      S new_storage(new_capacity);
+      T* new_nodes = nullptr;
+      size_type* new_out_degree = nullptr;
+      size_type* new_in_degree = nullptr;
+      try{
+        new_out_degree = _new_degrees(new_capacity);
+        new_in_degree = _new_degrees(new_capacity);
+        if(new_capacity > 0)
+          new_nodes = new T[new_capacity];
+        for(size_type i=0; i<_size; i++)
+          _transfer(new_nodes[i], _nodes[i]);
+      }
+      catch(...){
+        #ifndef NDEBUG 
+        std::cout<<"exception in _reallocate()"<<std::endl;
+        #endif   
+        delete[] new_nodes;
+        delete[] new_out_degree;
+        delete[] new_in_degree;
+        throw;
+      }
+
+      //move the old edges
+      new_storage.move_from(_storage, _size);
+      std::copy(_out_degree, _out_degree+_size, new_out_degree);
+      std::copy(_in_degree, _in_degree+_size, new_in_degree);
+
+      //delete old data structures
+      const size_type size = _size;
+      const std::size_t edges = _edges;
+      _clear();
+
+      //commit
+      _size = size;
+      _capacity = new_capacity;
+      _edges = edges;
+      _nodes = new_nodes;
+      _out_degree = new_out_degree;
+      _in_degree = new_in_degree;
+      _storage.swap(new_storage);
+    }
+
+    /**
+     * @brief add a node to the graph, copying or moving the label
+     *
+     * @param node the label, a const T& or a T&&
+     * @throw invalidNodeException the provided node already exist
+     * @throw std::bad_alloc 
+     * @return the position of the new node
+     */
+    template <typename U>
+    size_type _add_node(U &&node){
+      if(existsNode(node))
+        throw invalidNodeException();
+
+      //make room for the new node
+      _grow(_size+1);
+      size_type* new_buckets = nullptr;
+      const size_type new_bucket_count = _buckets_for(_size+1);
+      try{
+        if(new_bucket_count > _bucket_count)
+          new_buckets = new size_type[new_bucket_count];
+        // throw std::bad_alloc(); //TODO:remove. decomment to simulate malloc issue
+        if(_acyclic){
+          _rank.reserve(_size+1);
+          _ranked.reserve(_size+1);
+          _mark.reserve(_size+1);
+        }
+        //last, nothing that can throw comes after the label is moved
+        _nodes[_size] = std::forward<U>(node);
+      }
+      catch(...){
+        #ifndef NDEBUG 
+        std::cout<<"exception in addNode()"<<std::endl;
+        #endif   
+        delete[] new_buckets;
+        throw;
+      }
+
+      //commit. The row and column of the new node are already cleared,
+      //the new node can be last in the topological order
+      if(_acyclic){
+        _rank.push_back(_size);
+        _ranked.push_back(_size);
+        _mark.push_back(0);
+      }
+      _size++;
+
+      //update the hash index. When the table grows all the nodes are rehashed,
+      //which happens a logarithmic amount of times
+      if constexpr (_hashed){
+        if(new_buckets != nullptr){
+          delete[] _buckets;
+          _buckets = new_buckets;
+          _bucket_count = new_bucket_count;
+          _rebuild_index();
+        }
+        else
+          _index_insert(_size-1);
+      }
+      return _size-1;
+    }
+
+    /**
+     * @brief the position of a node id
+     *
+     * @throw invalidNodeException the id is not the position of a node
+     */
+    size_type _position(node_id id) const{
+      if(!_valid(id))
+        throw invalidNodeException();
+      return id._position;
+    }
+
+    /**
+     * @brief check that an id was issued by this graph, in the current epoch
+     *
+     */
+    bool _valid(node_id id) const{
+      return id._epoch == _epoch && id._position < _size;
+    }
+
+    /**
+     * @brief the id of the node at position i
+     *
+     */
+    node_id _id(size_type i) const{
+      return node_id(i, _epoch);
+    }
+
+    /**
+     * @brief add the edge between two node positions
+     *
+     * @throw invalidEdgeException the edge already exists
+     * @throw cycleException the graph is in acyclic mode, and the edge closes a cycle
+     * @throw std::bad_alloc
+     */
+    void _add_edge(size_type iFrom, size_type iTo, const weight_type &w){
+      if(_storage.test(iFrom, iTo))
+        throw invalidEdgeException();
+      if(_acyclic && !_order_edge(iFrom, iTo))
+        throw cycleException();
+      _storage.set(iFrom, iTo, w);
+      _out_degree[iFrom]++;
+      _in_degree[iTo]++;
+      _edges++;
+    }
+
+    /**
+     * @brief remove the edge between two node positions
+     *
+     * @throw invalidEdgeException the edge does not exist
+     */
+    void _remove_edge(size_type iFrom, size_type iTo){
+      if(!_storage.test(iFrom, iTo))
+        throw invalidEdgeException();
+      _storage.reset(iFrom, iTo);
+      _out_degree[iFrom]--;
+      _in_degree[iTo]--;
+      _edges--;
+    }
+
+    /**
+     * @brief move the hash index into a table of the given amount of buckets
+     *
+     * @param new_bucket_count a power of two, large enough for _size nodes
+     * @throw std::bad_alloc
+     * @post _bucket_count = new_bucket_count
+     */
+    void _reallocate_index(size_type new_bucket_count){
+      size_type* new_buckets = nullptr;
+      if(new_bucket_count > 0)
+        new_buckets = new size_type[new_bucket_count];
+      _clear_index();
+      _buckets = new_buckets;
+      _bucket_count = new_bucket_count;
+      _rebuild_index();
+    }
+
+    /**
+     * @brief delete the hash table
+     *
+     * @post _buckets = nullptr
+     * @post _bucket_count = 0
+     */
+    void _clear_index(){
+      delete[] _buckets;
+      _buckets = nullptr;
+      _bucket_count = 0;
+    }
+
+    /**
+     * @brief the amount of buckets the hash table needs for a given amount of nodes
+     *
+     * The table is kept at most half full, so that probe sequences stay short
+     *
+     * @param size the amount of nodes
+     * @return a power of two, or 0 when no hash table is needed
+     */
+    static size_type _buckets_for(size_type size){
+      if(!_hashed || size == 0)
+        return 0;
+      size_type count = 8;
+      while(count < size*2)
+        count *= 2;
+      return count;
+    }
+
+    /**
+     * @brief the first bucket in the probe sequence of a node
+     *
+     * The hash returned by H is scrambled with a multiplicative hash,
+     * so that functors returning the identity don't cluster the table
+     *
+     * @param node the node to hash
+     * @param bucket_count the amount of buckets, a power of two
+     */
+    size_type _bucket(const T &node, size_type bucket_count) const{
+      unsigned long long h = static_cast<unsigned long long>(_hash(node));
+      h *= 0x9E3779B97F4A7C15ull;
+      return static_cast<size_type>(h >> 32) & (bucket_count-1);
+    }
+
+    /**
+     * @brief insert the node at position i of _nodes in the hash table
+     *
+     * @pre the table has at least one empty bucket
+     * @param i the position of the node in _nodes
+     */
+    void _index_insert(size_type i){
+      const size_type mask = _bucket_count-1;
+      size_type b = _bucket(_nodes[i], _bucket_count);
+      while(_buckets[b] != _empty_bucket)
+        b = (b+1) & mask;
+      _buckets[b] = i;
+    }
+
+    /**
+     * @brief find the bucket that contains the node at position i of _nodes
+     *
+     * @pre the node is in the hash table
+     * @param i the position of the node in _nodes
+     * @return the bucket
+     */
+    size_type _bucket_of(size_type i) const{
+      const size_type mask = _bucket_count-1;
+      size_type b = _bucket(_nodes[i], _bucket_count);
+      while(_buckets[b] != i)
+        b = (b+1) & mask;
+      return b;
+    }
+
+    /**
+     * @brief remove a bucket from the hash table
+     *
+     * The following entries of the probe sequence are shifted back,
+     * so that the table never contains tombstones
+     *
+     * @param b the bucket to empty
+     */
+    void _index_erase(size_type b){
+      const size_type mask = _bucket_count-1;
+      size_type hole = b;
+      for(size_type next = (b+1) & mask; _buckets[next] != _empty_bucket; next = (next+1) & mask){
+        const size_type home = _bucket(_nodes[_buckets[next]], _bucket_count);
+        //the entry can fill the hole when the hole is between its home bucket and its bucket
+        if(((next - home) & mask) >= ((next - hole) & mask)){
+          _buckets[hole] = _buckets[next];
+          hole = next;
+        }
+      }
+      _buckets[hole] = _empty_bucket;
+    }
+
+    /**
+     * @brief fill the hash table with all the nodes in _nodes
+     *
+     * @pre _bucket_count >= _buckets_for(_size)
+     */
+    void _rebuild_index(){
+      if constexpr (_hashed){
+        for(size_type b=0; b<_bucket_count; b++)
+          _buckets[b] = _empty_bucket;
+        for(size_type i=0; i<_size; i++)
+          _index_insert(i);
+      }
+    }
+
+    /**
+     * @brief find the index position of a node in the _nodes list
+     *
+     * @param node the node to search
+     * @return the index position of the given node in _nodes
+     */
+    int _index(const T &node) const{
+      if constexpr (_hashed){
+        if(_bucket_count == 0)
+          return -1;
+        const size_type mask = _bucket_count-1;
+        for(size_type b = _bucket(node, _bucket_count); _buckets[b] != _empty_bucket; b = (b+1) & mask)
+          if(_eql(_nodes[_buckets[b]], node))
+            return _buckets[b];
+        return -1;
+      }
+      for(size_type i=0; i<_size; i++)
+        if(_eql(_nodes[i], node))
+          return i;
+      return -1;
+    }
+
+    /**
+     * @brief fill an empty graph with the given nodes
+     *
+     * The memory is allocated once, and duplicates are detected while
+     * building the hash index. Without a hash functor the duplicate
+     * detection compares all the pairs of nodes.
+     *
+     * @pre the graph is empty
+     * @param first the start of the node range
+     * @param last the end of the node range
+     * @throw std::bad_alloc
+     * @throw invalidNodeException there are duplicate nodes in the range
+     */
+    template <typename NodeIt>
+    void _load_nodes(NodeIt first, NodeIt last){
+      const size_type size = static_cast<size_type>(std::distance(first, last));
+      reserve(size);
+      for(size_type i=0; i<size; ++i, ++first){
+        _nodes[i] = *first;
+        //_size grows with the nodes, so that the linear lookup only sees the previous nodes
+        _size = i;
+        if(existsNode(_nodes[i]))
+          throw invalidNodeException();
+        if constexpr (_hashed)
+          _index_insert(i);
+      }
+      _size = size;
+    }
+
+    /**
+     * @brief fill a graph without edges with the given edges
+     *
+     * The labels are resolved to positions first, then the storage
+     * is filled in a single pass.
+     *
+     * @pre the graph has no edges
+     * @param first the start of the edge range
+     * @param last the end of the edge range
+     * @throw std::bad_alloc
+     * @throw invalidNodeException an edge refers to a node that does not exist
+     * @throw invalidEdgeException there are duplicate edges in the range
+     */
+    template <typename EdgeIt>
+    void _load_edges(EdgeIt first, EdgeIt last){
+      std::vector<size_type> from, to;
+      _resolve_edges(first, last, from, to);
+      const std::vector<weight_type> weights(_weighted ? from.size() : 0, _unit_weight());
+      _assign_edges(from, to, weights);
+    }
+
+    /**
+     * @brief fill a graph without edges with the given edges, by position
+     *
+     * @pre the graph has no edges, and the positions are < _size
+     * @param from the positions of the start nodes
+     * @param to the positions of the end nodes
+     * @param weights the weights of the edges, ignored without weights
+     * @throw std::bad_alloc
+     * @throw invalidEdgeException there are duplicate edges
+     */
+    void _assign_edges(const std::vector<size_type> &from, const std::vector<size_type> &to, const std::vector<weight_type> &weights){
+      if(!_storage.assign(_size, from.data(), to.data(), _weighted ? weights.data() : nullptr, from.size()))
+        throw invalidEdgeException();
+      for(std::size_t e=0; e<from.size(); e++){
+        _out_degree[from[e]]++;
+        _in_degree[to[e]]++;
+      }
+      _edges = from.size();
+    }
+
+    /**
+     * @brief the tag of the weights in the snapshot header, 0 without weights
+     *
+     */
+    static constexpr std::uint32_t _snapshot_weight_type(){
+      if constexpr (_weighted)
+        return snapshot_type_tag<weight_type>();
+      else
+        return 0;
+    }
+
+    /**
+     * @brief fill an empty graph with nodes that are known to be distinct
+     *
+     * @param labels the nodes, moved into the graph
+     * @throw std::bad_alloc
+     */
+    void _load_distinct(std::vector<T> &labels){
+      const size_type size = static_cast<size_type>(labels.size());
+      reserve(size);
+      for(size_type i=0; i<size; i++)
+        _transfer(_nodes[i], labels[i]);
+      _size = size;
+      _rebuild_index();
+    }
+
+    /**
+     * @brief write the adjacency matrix, see writeMatrix
+     *
+     * @throw exportException the output failed
+     */
+    void _write_matrix(export_buffer &out) const{
+      std::vector<char> row(_size * std::size_t(2) + 1, ' ');
+      row.back() = '\n';
+      for(size_type i=0; i<_size; i++){
+        for(size_type j=0; j<_size; j++)
+          row[j * std::size_t(2)] = '0';
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &){
+          row[j * std::size_t(2)] = '1';
+        });
+        out.put(row.data(), row.size());
+      }
+      if(!out.flush())
+        throw exportException();
+    }
+
+    /**
+     * @brief write the edge list, see writeEdgeList
+     *
+     * @throw exportException the output failed
+     */
+    template <typename L>
+    void _write_edge_list(export_buffer &out, const L &labels) const{
+      for(size_type i=0; i<_size; i++)
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &w){
+          labels.format(out, _nodes[i]);
+          out.put(' ');
+          labels.format(out, _nodes[j]);
+          if constexpr (_weighted && std::is_arithmetic<weight_type>::value){
+            out.put(' ');
+            out.number(w);
+          }
+          out.put('\n');
+        });
+      if(!out.flush())
+        throw exportException();
+    }
+
+    /**
+     * @brief write the DOT text, see writeDot
+     *
+     * @throw exportException the output failed
+     */
+    template <typename L>
+    void _write_dot(export_buffer &out, const L &labels) const{
+      out.put("digraph {\n");
+      for(size_type i=0; i<_size; i++){
+        out.put("  ");
+        out.number(i);
+        out.put(" [label=\"");
+        out.escape(true);
+        labels.text(out, _nodes[i]);
+        out.escape(false);
+        out.put("\"];\n");
+      }
+      for(size_type i=0; i<_size; i++)
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &w){
+          out.put("  ");
+          out.number(i);
+          out.put(" -> ");
+          out.number(j);
+          if constexpr (_weighted && std::is_arithmetic<weight_type>::value){
+            out.put(" [label=\"");
+            out.number(w);
+            out.put("\"]");
+          }
+          out.put(";\n");
+        });
+      out.put("}\n");
+      if(!out.flush())
+        throw exportException();
+    }
+
+    /**
+     * @brief resolve the labels of a range of edges to node positions
+     *
+     * @param first the start of the edge range
+     * @param last the end of the edge range
+     * @param from filled with the positions of the start nodes
+     * @param to filled with the positions of the end nodes
+     * @throw std::bad_alloc
+     * @throw invalidNodeException an edge refers to a node that does not exist
+     */
+    template <typename EdgeIt>
+    void _resolve_edges(EdgeIt first, EdgeIt last, std::vector<size_type> &from, std::vector<size_type> &to) const{
+      const std::size_t count = static_cast<std::size_t>(std::distance(first, last));
+      from.reserve(count);
+      to.reserve(count);
+      for(; first != last; ++first){
+        const int iFrom = _index(first->first);
+        const int iTo = _index(first->second);
+        if(iFrom == -1 || iTo == -1)
+          throw invalidNodeException();
+        from.push_back(iFrom);
+        to.push_back(iTo);
+      }
+    }
+
+    /**
+     * @brief resolve and sort a range of edges, rejecting duplicates
+     *
+     * @param first the start of the edge range
+     * @param last the end of the edge range
+     * @return the positions of the edges, sorted by start and end node
+     * @throw std::bad_alloc
+     * @throw invalidNodeException an edge refers to a node that does not exist
+     * @throw invalidEdgeException an edge appears twice in the range
+     */
+    template <typename EdgeIt>
+    std::vector<std::pair<size_type, size_type> > _sorted_edges(EdgeIt first, EdgeIt last) const{
+      std::vector<size_type> from, to;
+      _resolve_edges(first, last, from, to);
+      std::vector<std::pair<size_type, size_type> > edges(from.size());
+      for(std::size_t e=0; e<from.size(); e++)
+        edges[e] = std::make_pair(from[e], to[e]);
+      std::sort(edges.begin(), edges.end());
+      if(std::adjacent_find(edges.begin(), edges.end()) != edges.end())
+        throw invalidEdgeException();
+      return edges;
+    }
+
+    /**
+     * @brief make room for at least n nodes, growing the capacity geometrically
+     *
+     * @param n the amount of nodes to make room for
+     * @throw std::bad_alloc
+     */
+    void _grow(size_type n){
+      if(n > _capacity)
+        _reallocate(std::max(n, _capacity*2));
+    }
+
+    /**
+     * @brief visited set of a traversal, one bit per node position
+     *
+     */
+    typedef std::vector<std::uint64_t> _bitset;
+
+    static bool _test_bit(const _bitset &bits, size_type i){
+      return (bits[i / 64] >> (i % 64)) & 1;
+    }
+
+    static void _set_bit(_bitset &bits, size_type i){
+      bits[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+
+    /**
+     * @brief call a visitor with a node label
+     *
+     * @return true when the visitor returns a bool, and it is true
+     */
+    template <typename Visitor>
+    static bool _call_visitor(Visitor &visit, const T &node){
+      if constexpr (std::is_same<decltype(visit(node)), bool>::value)
+        return visit(node);
+      else{
+        visit(node);
+        return false;
+      }
+    }
+
+    /**
+     * @brief breadth first visit from a node position
+     *
+     * The queue is a single array of _size positions, since every
+     * node enters the queue at most once.
+     *
+     * @param start the position of the first node
+     * @param f called with the position of every reached node, in visit
+     *   order. The visit stops when it returns true
+     * @throw std::bad_alloc
+     * @return true when the visit was stopped by f
+     */
+    template <typename F>
+    bool _bfs(size_type start, F f) const{
+      _bitset visited((_size + 63) / 64, 0);
+      std::vector<size_type> queue(_size);
+      size_type head = 0, tail = 0;
+      queue[tail++] = start;
+      _set_bit(visited, start);
+      while(head < tail){
+        const size_type i = queue[head++];
+        if(f(i))
+          return true;
+        for(size_type j=_storage.next_out(i, 0, _size); j<_size; j=_storage.next_out(i, j+1, _size))
+          if(!_test_bit(visited, j)){
+            _set_bit(visited, j);
+            queue[tail++] = j;
+          }
+      }
+      return false;
+    }
+
+    /**
+     * @brief breadth first shortest paths, when every edge has length 1
+     *
+     * The queue of the visit is the workspace of the result.
+     *
+     * @param source the position of the first node
+     * @param paths the result, already reset
+     * @return false when a reached edge has a weight other than 1,
+     *   the result is then incomplete
+     */
+    bool _unit_paths(size_type source, shortest_paths &paths) const{
+      distance_type* dist = paths._distance.data();
+      size_type* parent = paths._parent.data();
+      size_type* queue = paths._queue.data();
+      size_type head = 0, tail = 0;
+      queue[tail++] = source;
+      dist[source] = 0;
+      bool unit = true;
+      while(head < tail && unit){
+        const size_type i = queue[head++];
+        const distance_type next = dist[i] + 1;
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &w){
+          if constexpr (_weighted)
+            unit = unit && w == weight_type(1);
+          if(dist[j] == shortest_paths::unreached){
+            dist[j] = next;
+            parent[j] = i;
+            queue[tail++] = j;
+          }
+        });
+      }
+      return unit;
+    }
+
+    /**
+     * @brief Dijkstra's shortest paths, on a radix heap, for integer weights
+     *
+     * The extracted distances never decrease, so a distance only has to
+     * be compared with the last extracted one: it goes in the bucket of
+     * the highest bit where they differ. Each entry moves to lower buckets
+     * at most 64 times, and the improved distances are pushed again
+     * instead of decreased, the stale entries are skipped.
+     *
+     * @param source the position of the first node
+     * @param paths the result, already reset
+     * @throw invalidEdgeException a reached edge has a negative weight
+     * @throw std::bad_alloc
+     */
+    void _radix_paths(size_type source, shortest_paths &paths) const{
+      distance_type* dist = paths._distance.data();
+      size_type* parent = paths._parent.data();
+      std::vector<std::pair<std::uint64_t, size_type> >* buckets = paths._radix;
+      std::uint64_t last = 0;
+      std::size_t count = 0;
+      auto bucket = [&](std::uint64_t d){
+        return d == last ? 0 : 64 - __builtin_clzll(d ^ last);
+      };
+
+      for(int b=0; b<65; b++)
+        buckets[b].clear();
+      dist[source] = 0;
+      buckets[0].push_back(std::make_pair(std::uint64_t(0), source));
+      count++;
+      while(count > 0){
+        if(buckets[0].empty()){
+          int b = 1;
+          while(buckets[b].empty())
+            b++;
+          last = buckets[b][0].first;
+          for(std::size_t e=1; e<buckets[b].size(); e++)
+            last = std::min(last, buckets[b][e].first);
+          for(std::size_t e=0; e<buckets[b].size(); e++)
+            buckets[bucket(buckets[b][e].first)].push_back(buckets[b][e]);
+          buckets[b].clear();
+        }
+        const std::pair<std::uint64_t, size_type> top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        const size_type i = top.second;
+        if(static_cast<std::uint64_t>(dist[i]) != top.first)
+          continue;
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &w){
+          if(w < 0)
+            throw invalidEdgeException();
+          const distance_type d = dist[i] + w;
+          if(!(d < dist[j]))
+            return;
+          dist[j] = d;
+          parent[j] = i;
+          buckets[bucket(d)].push_back(std::make_pair(static_cast<std::uint64_t>(d), j));
+          count++;
+        });
+      }
+    }
+
+    /**
+     * @brief arity of the heap of _weighted_paths
+     *
+     * Four children share a cache line of positions, and the heap is
+     * half as deep as a binary heap.
+     */
+    static constexpr size_type _heap_arity = 4;
+
+    /**
+     * @brief Dijkstra's shortest paths, on a d-ary heap with decrease-key
+     *
+     * Used for the weight types that are not integers.
+     * @param source the position of the first node
+     * @param paths the result, already reset
+     * @throw invalidEdgeException a reached edge has a negative weight
+     */
+    void _weighted_paths(size_type source, shortest_paths &paths) const{
+      distance_type* dist = paths._distance.data();
+      size_type* parent = paths._parent.data();
+      size_type* heap = paths._queue.data();
+      size_type* slot = paths._slot.data();
+      size_type count = 0;
+
+      //place node i in the hole at h, moving the hole up or down the heap
+      auto sift_up = [&](size_type h, size_type i){
+        while(h > 0){
+          const size_type up = (h - 1) / _heap_arity;
+          if(!(dist[i] < dist[heap[up]]))
+            break;
+          heap[h] = heap[up];
+          slot[heap[h]] = h;
+          h = up;
+        }
+        heap[h] = i;
+        slot[i] = h;
+      };
+      auto sift_down = [&](size_type h, size_type i){
+        for(;;){
+          const size_type first = h * _heap_arity + 1;
+          if(first >= count)
+            break;
+          const size_type last = std::min(first + _heap_arity, count);
+          size_type best = first;
+          for(size_type c=first+1; c<last; c++)
+            if(dist[heap[c]] < dist[heap[best]])
+              best = c;
+          if(!(dist[heap[best]] < dist[i]))
+            break;
+          heap[h] = heap[best];
+          slot[heap[h]] = h;
+          h = best;
+        }
+        heap[h] = i;
+        slot[i] = h;
+      };
+
+      dist[source] = 0;
+      heap[count++] = source;
+      slot[source] = 0;
+      while(count > 0){
+        const size_type i = heap[0];
+        slot[i] = shortest_paths::none;
+        if(--count > 0)
+          sift_down(0, heap[count]);
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &w){
+          if(w < weight_type(0))
+            throw invalidEdgeException();
+          const distance_type d = dist[i] + w;
+          if(!(d < dist[j]))
+            return;
+          const bool queued = dist[j] != shortest_paths::unreached;
+          dist[j] = d;
+          parent[j] = i;
+          if(queued)
+            sift_up(slot[j], j);
+          else
+            sift_up(count++, j);
+        });
+      }
+    }
+
+    /**
+     * @brief the distance of the pairs without a path, during allPairsShortestPaths
+     *
+     * Half of the largest signed value, so the sum of two distances
+     * never overflows, and the int kernels also fit the unsigned types.
+     */
+    static distance_type _path_infinity(){
+      if constexpr (std::numeric_limits<distance_type>::has_infinity)
+        return std::numeric_limits<distance_type>::infinity();
+      else
+        return std::numeric_limits<typename std::make_signed<distance_type>::type>::max() / 2;
+    }
+
+    /**
+     * @brief min-plus update of a tile of the distance matrix
+     *
+     * For every pivot k in [k0, k0 + depth) and every row i of the tile:
+     * d[i][j] = min(d[i][j], d[i][k] + d[k][j]) for j in [j0, j0 + width).
+     * The pivots are the outer loop, so the tile can share its rows or
+     * its columns with the pivots.
+     *
+     * @param d the distance matrix
+     * @param stride the row stride of the matrix
+     * @param i0 the first row of the tile
+     * @param height the amount of rows of the tile
+     * @param j0 the first column of the tile
+     * @param width the amount of columns of the tile
+     * @param k0 the first pivot
+     * @param depth the amount of pivots
+     */
+    static void _relax_tile(distance_type* d, std::size_t stride, size_type i0, size_type height,
+        size_type j0, size_type width, size_type k0, size_type depth){
+      const distance_type infinity = _path_infinity();
+      for(size_type k=k0; k<k0+depth; k++){
+        const distance_type* pivot = d + k * stride + j0;
+        for(size_type i=i0; i<i0+height; i++){
+          const distance_type through = d[i * stride + k];
+          if(!(through < infinity))
+            continue;
+          distance_type* row = d + i * stride + j0;
+          if constexpr (std::is_integral<distance_type>::value && sizeof(distance_type) == sizeof(int))
+            simd_dispatch().relax(reinterpret_cast<int*>(row), reinterpret_cast<const int*>(pivot), static_cast<int>(through), width);
+          else if constexpr (std::is_integral<distance_type>::value && sizeof(distance_type) == sizeof(long long))
+            simd_dispatch().relax_wide(reinterpret_cast<long long*>(row), reinterpret_cast<const long long*>(pivot),
+              static_cast<long long>(through), width);
+          else
+            for(size_type j=0; j<width; j++)
+              row[j] = std::min(row[j], pivot[j] + through);
+        }
+      }
+    }
+
+    /**
+     * @brief depth first visit from a node position, in preorder
+     *
+     * The stack keeps, for every open node, the position from which
+     * its row scan resumes, so every row is scanned once.
+     *
+     * @param start the position of the first node
+     * @param f called with the position of every reached node, in visit
+     *   order. The visit stops when it returns true
+     * @throw std::bad_alloc
+     * @return true when the visit was stopped by f
+     */
+    template <typename F>
+    bool _dfs(size_type start, F f) const{
+      _bitset visited((_size + 63) / 64, 0);
+      std::vector<size_type> stack(_size), resume(_size);
+      size_type top = 0;
+      _set_bit(visited, start);
+      if(f(start))
+        return true;
+      stack[top] = start;
+      resume[top++] = 0;
+      while(top > 0){
+        const size_type i = stack[top-1];
+        const size_type j = _storage.next_out(i, resume[top-1], _size);
+        if(j == _size){
+          top--;
+          continue;
+        }
+        resume[top-1] = j+1;
+        if(!_test_bit(visited, j)){
+          _set_bit(visited, j);
+          if(f(j))
+            return true;
+          stack[top] = j;
+          resume[top++] = 0;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @brief parallel, direction optimizing breadth first visit
+     *
+     * The visit proceeds by levels. A top-down step expands the successors
+     * of the frontier, the threads claim the new nodes with an atomic
+     * update of the visited bitset. A bottom-up step looks, for every
+     * unvisited node, for a predecessor in the frontier, and stops at the
+     * first one: it's cheaper when the frontier is large. The direction
+     * is chosen at every level with the heuristic of Beamer et al.
+     * using the degree counters.
+     *
+     * @param start the position of the first node
+     * @param threads the amount of threads, 0 for all the cores
+     * @param f called with the position and the depth of every reached node,
+     *   on the calling thread, by increasing depth and then position
+     * @throw std::bad_alloc
+     * @throw std::system_error a thread could not be started
+     */
+    template <typename F>
+    void _parallel_bfs(size_type start, unsigned threads, F f) const{
+      //tuning of the direction switch, from the paper
+      const std::size_t alpha = 14, beta = 24;
+      //nodes per work item in top-down steps, bitset words in bottom-up steps
+      const std::size_t chunk = 64, chunk_words = 4;
+
+      const std::size_t words = (_size + 63) / 64;
+      std::vector<std::atomic<std::uint64_t> > visited(words);
+      _bitset frontier_bits(words, 0);
+      std::vector<size_type> frontier(1, start);
+      parallel_team team(parallel_threads(threads));
+      std::vector<std::vector<size_type> > found(team.size());
+
+      visited[start / 64].store(std::uint64_t(1) << (start % 64), std::memory_order_relaxed);
+      std::size_t unexplored = _edges - _in_degree[start];
+      bool bottom_up = false;
+
+      for(size_type depth=0; !frontier.empty(); depth++){
+        for(std::size_t k=0; k<frontier.size(); k++)
+          f(frontier[k], depth);
+
+        std::size_t frontier_edges = 0;
+        for(std::size_t k=0; k<frontier.size(); k++)
+          frontier_edges += _out_degree[frontier[k]];
+        if(!bottom_up && frontier_edges > unexplored / alpha)
+          bottom_up = true;
+        else if(bottom_up && frontier.size() < _size / beta)
+          bottom_up = false;
+
+        std::atomic<std::size_t> cursor(0);
+        if(bottom_up){
+          std::fill(frontier_bits.begin(), frontier_bits.end(), 0);
+          for(std::size_t k=0; k<frontier.size(); k++)
+            _set_bit(frontier_bits, frontier[k]);
+          team.run([&](unsigned t){
+            for(;;){
+              const std::size_t first = cursor.fetch_add(chunk_words, std::memory_order_relaxed);
+              if(first >= words)
+                break;
+              const std::size_t last = std::min(first + chunk_words, words);
+              //every word is handled by a single thread
+              for(std::size_t w=first; w<last; w++){
+                std::uint64_t open = ~visited[w].load(std::memory_order_relaxed);
+                if(w == words-1 && _size % 64 != 0)
+                  open &= (std::uint64_t(1) << (_size % 64)) - 1;
+                std::uint64_t reached = 0;
+                for(; open != 0; open &= open - 1){
+                  const size_type v = static_cast<size_type>(w * 64 + __builtin_ctzll(open));
+                  for(size_type u=_storage.next_in(v, 0, _size); u<_size; u=_storage.next_in(v, u+1, _size))
+                    if(_test_bit(frontier_bits, u)){
+                      reached |= open & (~open + 1);
+                      found[t].push_back(v);
+                      break;
+                    }
+                }
+                if(reached != 0)
+                  visited[w].fetch_or(reached, std::memory_order_relaxed);
+              }
+            }
+          });
+        }
+        else{
+          team.run([&](unsigned t){
+            for(;;){
+              const std::size_t first = cursor.fetch_add(chunk, std::memory_order_relaxed);
+              if(first >= frontier.size())
+                break;
+              const std::size_t last = std::min(first + chunk, frontier.size());
+              for(std::size_t k=first; k<last; k++){
+                const size_type u = frontier[k];
+                for(size_type v=_storage.next_out(u, 0, _size); v<_size; v=_storage.next_out(u, v+1, _size)){
+                  const std::uint64_t bit = std::uint64_t(1) << (v % 64);
+                  if(visited[v / 64].load(std::memory_order_relaxed) & bit)
+                    continue;
+                  if(!(visited[v / 64].fetch_or(bit, std::memory_order_relaxed) & bit))
+                    found[t].push_back(v);
+                }
+              }
+            }
+          });
+        }
+
+        //the next frontier does not depend on the scheduling of the threads
+        frontier.clear();
+        for(unsigned t=0; t<team.size(); t++){
+          frontier.insert(frontier.end(), found[t].begin(), found[t].end());
+          found[t].clear();
+        }
+        std::sort(frontier.begin(), frontier.end());
+        for(std::size_t k=0; k<frontier.size(); k++)
+          unexplored -= _in_degree[frontier[k]];
+      }
+    }
+
+    /**
+     * @brief compute a topological order with Kahn's algorithm
+     *
+     * @param order filled with the node positions, in topological order
+     * @return false when the graph has a cycle
+     * @throw std::bad_alloc
+     */
+    bool _topological_order(std::vector<size_type> &order) const{
+      std::vector<size_type> missing(_in_degree, _in_degree+_size);
+      order.clear();
+      order.reserve(_size);
+      for(size_type i=0; i<_size; i++)
+        if(missing[i] == 0)
+          order.push_back(i);
+      for(size_type k=0; k<order.size(); k++){
+        const size_type i = order[k];
+        for(size_type j=_storage.next_out(i, 0, _size); j<_size; j=_storage.next_out(i, j+1, _size))
+          if(--missing[j] == 0)
+            order.push_back(j);
+      }
+      return order.size() == _size;
+    }
+
+    /**
+     * @brief update the topological order for a new edge, in acyclic mode
+     *
+     * Pearce-Kelly algorithm: when the edge goes against the order, only
+     * the nodes ranked between the two ends are visited. The nodes reachable
+     * from y and the nodes that reach x are moved, keeping their relative
+     * order, so that the second group comes first.
+     * Provides the strong exception guarantee.
+     *
+     * @param x the position of the start node
+     * @param y the position of the end node
+     * @return false when the edge closes a cycle, and the order is unchanged
+     * @throw std::bad_alloc
+     */
+    bool _order_edge(size_type x, size_type y){
+      if(x == y)
+        return false;
+      const size_type low = _rank[y], high = _rank[x];
+      if(high < low)
+        return true;
+
+      std::vector<size_type> forward, backward, stack;
+      bool cycle = false;
+      try{
+        //nodes reachable from y, ranked before x
+        _mark[y] = 1;
+        forward.push_back(y);
+        stack.push_back(y);
+        while(!stack.empty() && !cycle){
+          const size_type i = stack.back();
+          stack.pop_back();
+          for(size_type j=_storage.next_out(i, 0, _size); j<_size; j=_storage.next_out(i, j+1, _size)){
+            if(j == x){
+              cycle = true;
+              break;
+            }
+            if(_mark[j] == 0 && _rank[j] < high){
+              _mark[j] = 1;
+              forward.push_back(j);
+              stack.push_back(j);
+            }
+          }
+        }
+        //nodes that reach x, ranked after y
+        if(!cycle){
+          _mark[x] = 2;
+          backward.push_back(x);
+          stack.assign(1, x);
+          while(!stack.empty()){
+            const size_type j = stack.back();
+            stack.pop_back();
+            for(size_type i=_storage.next_in(j, 0, _size); i<_size; i=_storage.next_in(j, i+1, _size))
+              if(_mark[i] == 0 && _rank[i] > low){
+                _mark[i] = 2;
+                backward.push_back(i);
+                stack.push_back(i);
+              }
+          }
+        }
+      }
+      catch(...){
+        for(std::size_t k=0; k<forward.size(); k++)
+          _mark[forward[k]] = 0;
+        for(std::size_t k=0; k<backward.size(); k++)
+          _mark[backward[k]] = 0;
+        throw;
+      }
+      for(std::size_t k=0; k<forward.size(); k++)
+        _mark[forward[k]] = 0;
+      for(std::size_t k=0; k<backward.size(); k++)
+        _mark[backward[k]] = 0;
+      if(cycle)
+        return false;
+
+      //reuse the ranks of the moved nodes: backward first, then forward
+      auto by_rank = [this](size_type a, size_type b){ return _rank[a] < _rank[b]; };
+      std::sort(forward.begin(), forward.end(), by_rank);
+      std::sort(backward.begin(), backward.end(), by_rank);
+      std::vector<size_type> ranks;
+      ranks.reserve(forward.size() + backward.size());
+      for(std::size_t k=0; k<backward.size(); k++)
+        ranks.push_back(_rank[backward[k]]);
+      for(std::size_t k=0; k<forward.size(); k++)
+        ranks.push_back(_rank[forward[k]]);
+      std::sort(ranks.begin(), ranks.end());
+      std::size_t r = 0;
+      for(std::size_t k=0; k<backward.size(); k++, r++){
+        _rank[backward[k]] = ranks[r];
+        _ranked[ranks[r]] = backward[k];
+      }
+      for(std::size_t k=0; k<forward.size(); k++, r++){
+        _rank[forward[k]] = ranks[r];
+        _ranked[ranks[r]] = forward[k];
+      }
+      return true;
+    }
+
+  //special members
+  public:
+
+    /**
+     * @brief graph of the strongly connected components, see condensation()
+     *
+     */
+    typedef oriented_graph<size_type, id_equal, id_hash, S> condensation_type;
+
+    /**
+     * @brief Default constructor
+     *
+     * @post _size = 0
+     * @post _nodes = nullptr
+     * @post _capacity = 0
+    */
+    oriented_graph() : _size(0), _capacity(0), _nodes(nullptr), _edges(0), _out_degree(nullptr), _in_degree(nullptr), _acyclic(false), _buckets(nullptr), _bucket_count(0) {
+      #ifndef NDEBUG 
+      std::cout<<"oriented_graph()"<<std::endl;
+      #endif
+    }
+
+    /**
+     * @brief Secondary constructor
+     *
+     * @param nodes a list of nodes that are part of the graph
+     * @param size the nodes list size
+     *
+     * @throw std::bad_alloc 
+     * @throw invalidNodeException there are duplicate nodes in the provided nodes list
+     * @post _size = size
+     * @post _nodes != nullptr
+     * @post _capacity >= size
+     */
+    oriented_graph(const T* const nodes, const size_type size) : _size(0), _capacity(0), _nodes(nullptr), _edges(0), _out_degree(nullptr), _in_degree(nullptr), _acyclic(false), _buckets(nullptr), _bucket_count(0) {
+      #ifndef NDEBUG 
+      std::cout<<"oriented_graph(nodes, size)"<<std::endl;
+      #endif
+
+      try{
+        _load_nodes(nodes, nodes+size);
+      }
+      catch(...){
+        #ifndef NDEBUG 
+        std::cout<<"exception in oriented_graph(nodes, size)"<<std::endl;
+        #endif   
+        //objects that throw exceptions in the constructors are considered not initialized
+        //therefore their destructor will not be called in the stack unwind mechanism.
+        //we must free the content ourselves to avoid memory leaks.
+        _clear();
+        _clear_index();
+        throw;
+      }
+    }
+
+    /**
+     * @brief Bulk constructor
+     *
+     * Builds the graph from a range of nodes and a range of edges,
+     * with a single allocation of the graph data.
+     * With a hash functor the construction takes linear time.
+     *
+     * @param nodes_first the start of the node range
+     * @param nodes_last the end of the node range
+     * @param edges_first the start of the edge range. The edges
+     *   have first and second members with the labels of the
+     *   start and end node, like std::pair<T, T>
+     * @param edges_last the end of the edge range
+     *
+     * @throw std::bad_alloc 
+     * @throw invalidNodeException there are duplicate nodes in the node range,
+     *   or an edge refers to a node that is not in the node range
+     * @throw invalidEdgeException there are duplicate edges in the edge range
+     * @post _size = the length of the node range
+     */
+    template <typename NodeIt, typename EdgeIt>
+    oriented_graph(NodeIt nodes_first, NodeIt nodes_last, EdgeIt edges_first, EdgeIt edges_last) :
+      _size(0), _capacity(0), _nodes(nullptr), _edges(0), _out_degree(nullptr), _in_degree(nullptr), _acyclic(false), _buckets(nullptr), _bucket_count(0) {
+      #ifndef NDEBUG 
+      std::cout<<"oriented_graph(nodes, edges)"<<std::endl;
+      #endif
+
+      try{
+        _load_nodes(nodes_first, nodes_last);
+        _load_edges(edges_first, edges_last);
+      }
+      catch(...){
+        #ifndef NDEBUG 
+        std::cout<<"exception in oriented_graph(nodes, edges)"<<std::endl;
+        #endif   
+        _clear();
+        _clear_index();
+        throw;
+      }
+    }
+
+    /**
+     * @brief Destructor
+     *
+     * @post _size = 0
+     * @post _nodes = nullptr
+     * @post _capacity = 0
+     */
+    ~oriented_graph(){
+      _clear();
+      _clear_index();
+      #ifndef NDEBUG 
+      std::cout<<"~oriented_graph()"<<std::endl;
+      #endif   
+    }
+
+    /**
+     * @brief swap the state of the current instance with the given instance
+     *
+     * @param other the instance to swap with
+     * @post _size != _size
+     * @post _capacity != _capacity
+     * @post _nodes != _nodes
+     * @post _storage != _storage
+     */
+    void swap(oriented_graph &other) noexcept {
+      std::swap(_size,other._size);
+      std::swap(_capacity,other._capacity);
+      std::swap(_nodes,other._nodes);
+      _storage.swap(other._storage);
+      std::swap(_edges,other._edges);
+      std::swap(_out_degree,other._out_degree);
+      std::swap(_in_degree,other._in_degree);
+      std::swap(_acyclic,other._acyclic);
+      std::swap(_epoch,other._epoch);
+      _rank.swap(other._rank);
+      _ranked.swap(other._ranked);
+      _mark.swap(other._mark);
+      std::swap(_buckets,other._buckets);
+      std::swap(_bucket_count,other._bucket_count);
+      std::swap(_eql,other._eql);
+      std::swap(_hash,other._hash);
+    }
+
+    /**
+     * @brief copy constructor
+     *
+     * @param other object to copy
+     * @throw std::bad_alloc 
+     * @post _size = size
+     * @post _nodes != nullptr
+     * @post _capacity >= size
+     */
+    oriented_graph(const oriented_graph &other): _size(0), _capacity(0), _nodes(nullptr), _edges(0), _out_degree(nullptr), _in_degree(nullptr), _acyclic(false), _buckets(nullptr), _bucket_count(0) {
+      #ifndef NDEBUG 
+      std::cout<<"oriented_graph(&oriented_graph)"<<std::endl;
+      #endif   
+      //copy without edges
+      try{
+        reserve(other._size);
+        for(size_type i=0; i<other._size; i++){
+          _nodes[i] = other._nodes[i];
+        }
+        //copy edges
+        _storage.copy_from(other._storage, other._size);
+        _rank = other._rank;
+        _ranked = other._ranked;
+        _mark = other._mark;
+      }
+      catch(...){
+        _clear();
+        _clear_index();
+        throw;
+      }
+      _acyclic = other._acyclic;
+      std::copy(other._out_degree, other._out_degree+other._size, _out_degree);
+      std::copy(other._in_degree, other._in_degree+other._size, _in_degree);
+      _edges = other._edges;
+      _size = other._size;
+      _rebuild_index();
+    }
+
+    /**
+     * @brief copy assignment
+     *
+     * @param other the element to copy
+     * @return reference to current graph, post-copy
+     * @throw std::bad_alloc 
+     * @post _size != _size
+     * @post _nodes != _nodes
+     * @post _storage != _storage
+     */
+    oriented_graph& operator=(const oriented_graph &other){
+      if (&other != this) {
+        oriented_graph tmp(other);
+        this->swap(tmp); 
+      }
+      return *this;
+    }
+
+    /**
+     * @brief move constructor
+     *
+     * Takes the data of other without copying any node or edge.
+     *
+     * @param other the graph to take the data from, left empty
+     * @post other._size = 0
+     * @post other._nodes = nullptr
+     */
+    oriented_graph(oriented_graph &&other) noexcept : _size(0), _capacity(0), _nodes(nullptr), _edges(0), _out_degree(nullptr), _in_degree(nullptr), _acyclic(false), _buckets(nullptr), _bucket_count(0) {
+      #ifndef NDEBUG 
+      std::cout<<"oriented_graph(&&oriented_graph)"<<std::endl;
+      #endif   
+      this->swap(other);
+    }
+
+    /**
+     * @brief move assignment
+     *
+     * The previous data of the current graph is deleted.
+     *
+     * @param other the graph to take the data from, left empty
+     * @return reference to current graph
+     * @post other._size = 0
+     */
+    oriented_graph& operator=(oriented_graph &&other) noexcept {
+      if (&other != this) {
+        oriented_graph tmp(std::move(other));
+        this->swap(tmp);
+      }
+      return *this;
+    }
+
+  //public interface
+  public:
+
+    /**
+     * @brief graph nodes size getter
+     *
+     * @return the amount of nodes in the graph
+     */
+    size_type nodes() const{
+      return _size;
+    }
+
+    /**
+     * @brief graph capacity getter
+     *
+     * @return the amount of nodes the graph can hold without reallocating
+     */
+    size_type capacity() const{
+      return _capacity;
+    }
+
+    /**
+     * @brief make room for at least n nodes
+     *
+     * Use this before bulk loading a graph, to avoid reallocations.
+     * Provides the strong exception guarantee.
+     *
+     * @param n the amount of nodes to make room for
+     * @throw std::bad_alloc
+     * @post _capacity >= n
+     */
+    void reserve(size_type n){
+      if(n > _capacity)
+        _reallocate(n);
+      const size_type bucket_count = _buckets_for(n);
+      if(bucket_count > _bucket_count)
+        _reallocate_index(bucket_count);
+    }
+
+    /**
+     * @brief compact the edges in a form that is faster to read
+     *
+     * Call this before a read-heavy phase. With sparse_storage the
+     * adjacency lists are packed in a single CSR block, and the first
+     * edge insertion moves them back to the mutable form.
+     * With the matrix storages this is a no-op.
+     *
+     * @throw std::bad_alloc
+     */
+    void freeze(){
+      _storage.freeze(_size);
+    }
+
+    /**
+     * @brief release the memory that is not used by the current nodes
+     *
+     * Provides the strong exception guarantee.
+     *
+     * @throw std::bad_alloc
+     * @post _capacity = _size
+     */
+    void shrink_to_fit(){
+      if(_capacity > _size)
+        _reallocate(_size);
+      const size_type bucket_count = _buckets_for(_size);
+      if(bucket_count < _bucket_count)
+        _reallocate_index(bucket_count);
+    }
+
+    /**
+     * @brief graph edges size getter
+     *
+     * The amount of edges is kept up to date by the mutators,
+     * so this takes constant time.
+     *
+     * @return the amount of edges in the graph
+     */
+    int edges() const{
+      return static_cast<int>(_edges);
+    }
+
+    /**
+     * @brief the amount of edges leaving a node, in constant time
+     *
+     * @param node the start node of the edges
+     * @return the out degree of the node
+     * @throw invalidNodeException the provided node does not exist
+     */
+    size_type outDegree(const T &node) const{
+      const int i = _index(node);
+      if(i == -1)
+        throw invalidNodeException();
+      return _out_degree[i];
+    }
+
+    /**
+     * @brief the amount of edges leaving a node, given by id
+     *
+     * @throw invalidNodeException the id is not the position of a node
+     */
+    size_type outDegree(node_id node) const{
+      return _out_degree[_position(node)];
+    }
+
+    /**
+     * @brief the amount of edges entering a node, in constant time
+     *
+     * @param node the end node of the edges
+     * @return the in degree of the node
+     * @throw invalidNodeException the provided node does not exist
+     */
+    size_type inDegree(const T &node) const{
+      const int i = _index(node);
+      if(i == -1)
+        throw invalidNodeException();
+      return _in_degree[i];
+    }
+
+    /**
+     * @brief the amount of edges entering a node, given by id
+     *
+     * @throw invalidNodeException the id is not the position of a node
+     */
+    size_type inDegree(node_id node) const{
+      return _in_degree[_position(node)];
+    }
+
+    /**
+     * @brief print the adjacency matrix to stdout, see writeMatrix
+     *
+     * @throw exportException stdout rejected the output
+     */
+    void print() const{
+      writeMatrix(std::cout);
+    }
+
+    /**
+     * @brief write the adjacency matrix, a row of 0 and 1 per node
+     *
+     * The rows are in position order, and every cell is followed by a space.
+     * A row is built in a buffer from the successors of the node,
+     * so the cost of a row is its length plus the out degree.
+     *
+     * @param out the stream
+     * @throw exportException the stream rejected the output
+     */
+    void writeMatrix(std::ostream &out) const{
+      export_buffer buffer(out);
+      _write_matrix(buffer);
+    }
+
+    /**
+     * @brief write the adjacency matrix to a file descriptor, see writeMatrix
+     *
+     * @param fd the file descriptor, left open
+     * @throw exportException the output could not be written
+     */
+    void writeMatrix(int fd) const{
+      export_buffer buffer(fd);
+      _write_matrix(buffer);
+    }
+
+    /**
+     * @brief write the edges as a text edge list, see ograph_edgelist.hpp
+     *
+     * One line per edge, with the labels of the two nodes and the weight
+     * when the weights are numbers. The list reads back with readEdgeList,
+     * but the nodes without edges are not part of it.
+     *
+     * @param out the stream
+     * @param labels the label formatter, edge_list_labels writes numbers
+     * @throw exportException the stream rejected the output
+     */
+    template <typename L = edge_list_labels<T> >
+    void writeEdgeList(std::ostream &out, const L &labels = L()) const{
+      export_buffer buffer(out);
+      _write_edge_list(buffer, labels);
+    }
+
+    /**
+     * @brief write the edges to a file descriptor, see writeEdgeList
+     *
+     * @param fd the file descriptor, left open
+     * @param labels the label formatter
+     * @throw exportException the output could not be written
+     */
+    template <typename L = edge_list_labels<T> >
+    void writeEdgeList(int fd, const L &labels = L()) const{
+      export_buffer buffer(fd);
+      _write_edge_list(buffer, labels);
+    }
+
+    /**
+     * @brief write the graph in the DOT language of Graphviz
+     *
+     * The nodes are named by position, with the label as the label
+     * attribute. The weights that are numbers label the edges.
+     *
+     * @param out the stream
+     * @param labels the label formatter, edge_list_labels writes numbers
+     * @throw exportException the stream rejected the output
+     */
+    template <typename L = edge_list_labels<T> >
+    void writeDot(std::ostream &out, const L &labels = L()) const{
+      export_buffer buffer(out);
+      _write_dot(buffer, labels);
+    }
+
+    /**
+     * @brief write the graph to a file descriptor, see writeDot
+     *
+     * @param fd the file descriptor, left open
+     * @param labels the label formatter
+     * @throw exportException the output could not be written
+     */
+    template <typename L = edge_list_labels<T> >
+    void writeDot(int fd, const L &labels = L()) const{
+      export_buffer buffer(fd);
+      _write_dot(buffer, labels);
+    }
+
+    /**
+     * @brief save the graph to a snapshot file, see ograph_snapshot.hpp
+     *
+     * The adjacency section is the image of the storage, so load can map
+     * it in place of reading it. The acyclic mode is saved with the graph.
+     *
+     * The snapshot is written to path + ".tmp", then renamed over path.
+     * The old file is replaced and not rewritten, so the graphs mapped
+     * from it, this one included, keep their pages.
+     *
+     * @param path the file, replaced
+     * @param labels the label serializer, snapshot_labels copies the bytes
+     *   of trivially copyable labels
+     * @throw snapshotException the file could not be written
+     */
+    template <typename L = snapshot_labels<T> >
+    void save(const std::string &path, const L &labels = L()) const{
+      const std::string temporary = path + ".tmp";
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      if(!out)
+        throw snapshotException();
+      snapshot_header header = snapshot_header();
+      std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+      header.version = snapshot_version;
+      header.byte_order = 0x01020304;
+      header.storage = S::snapshot_kind;
+      header.weight_size = _weighted ? sizeof(weight_type) : 0;
+      header.label_size = L::label_size;
+      header.nodes = _size;
+      header.flags = _acyclic ? snapshot_acyclic : 0;
+      header.weight_type = _snapshot_weight_type();
+      header.label_type = L::label_type;
+      header.edges = _edges;
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+      for(size_type i=0; i<_size; i++)
+        labels.write(out, _nodes[i]);
+      header.degrees_offset = static_cast<std::uint64_t>(out.tellp());
+      out.write(reinterpret_cast<const char*>(_out_degree), _size * sizeof(size_type));
+      out.write(reinterpret_cast<const char*>(_in_degree), _size * sizeof(size_type));
+
+      //only the images that can be mapped need the alignment
+      const std::uint64_t end = static_cast<std::uint64_t>(out.tellp());
+      header.adjacency_offset = end;
+      if(S::mappable)
+        header.adjacency_offset = (end + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+      const std::vector<char> padding(header.adjacency_offset - end);
+      out.write(padding.data(), padding.size());
+      header.adjacency_size = _storage.image_size(_size);
+      _storage.write_image(out, _size);
+
+      out.seekp(0);
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.close();
+      if(!out || std::rename(temporary.c_str(), path.c_str()) != 0){
+        std::remove(temporary.c_str());
+        throw snapshotException();
+      }
+    }
+
+    /**
+     * @brief load a graph from a snapshot file written by save
+     *
+     * With map, the matrix storages use a private mapping of the adjacency
+     * section in place of reading it: the matrix is neither allocated nor
+     * copied. Writes to the graph copy the touched pages, and never reach
+     * the file. Without map, or when the file cannot be mapped, the
+     * section is read. A mapped file must not be rewritten in place while
+     * the graph lives, save replaces the file instead.
+     *
+     * The adjacency is checked to only hold edges between the nodes, and
+     * the degrees and the amount of edges in the file are checked against
+     * the degrees counted on it, so the load costs two scans of the
+     * adjacency.
+     *
+     * @param path the file
+     * @param map true to map the adjacency section when the storage allows it
+     * @param labels the label serializer used by save
+     * @return the graph
+     * @throw snapshotException the file is missing, truncated, not consistent,
+     *   or does not match the label, weight or storage type of this graph
+     * @throw std::bad_alloc
+     */
+    template <typename L = snapshot_labels<T> >
+    static oriented_graph load(const std::string &path, bool map = true, const L &labels = L()){
+      std::ifstream in(path, std::ios::binary);
+      if(!in)
+        throw snapshotException();
+      in.seekg(0, std::ios::end);
+      const std::uint64_t file_size = static_cast<std::uint64_t>(in.tellg());
+      in.seekg(0);
+      snapshot_header header;
+      in.read(reinterpret_cast<char*>(&header), sizeof(header));
+      if(!in || std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 ||
+          header.version != snapshot_version || header.byte_order != 0x01020304 ||
+          header.storage != S::snapshot_kind || header.weight_size != (_weighted ? sizeof(weight_type) : 0) ||
+          header.label_size != L::label_size || header.label_type != L::label_type ||
+          header.weight_type != _snapshot_weight_type() ||
+          (header.flags & ~snapshot_acyclic) != 0 || header.reserved != 0 ||
+          header.adjacency_offset > file_size || header.adjacency_size > file_size - header.adjacency_offset)
+        throw snapshotException();
+
+      //the sizes in the header are checked on the file before anything is allocated
+      const size_type n = header.nodes;
+      const std::uint64_t degrees_size = std::uint64_t(2) * n * sizeof(size_type);
+      if(header.degrees_offset < sizeof(header) || header.degrees_offset > file_size ||
+          degrees_size > file_size - header.degrees_offset ||
+          std::uint64_t(n) * L::label_size > header.degrees_offset - sizeof(header))
+        throw snapshotException();
+      if constexpr (!S::mappable){
+        //the image is an edge list, sized by the amount of edges
+        const std::uint64_t edge_size = 2 * sizeof(size_type) + header.weight_size;
+        if(header.edges > header.adjacency_size / edge_size || header.adjacency_size != header.edges * edge_size)
+          throw snapshotException();
+      }
+
+      //the arrays are allocated with the exact size, _reallocate would also allocate a matrix
+      oriented_graph g;
+      if(n > 0)
+        g._nodes = new T[n];
+      g._capacity = n;
+      g._out_degree = _new_degrees(n);
+      g._in_degree = _new_degrees(n);
+      //every label is read within the label section, which it must fill
+      std::uint64_t position = sizeof(header);
+      for(size_type i=0; i<n; i++){
+        labels.read(in, g._nodes[i], header.degrees_offset - position);
+        if(!in)
+          throw snapshotException();
+        if constexpr (L::label_size != 0)
+          position += L::label_size;
+        else
+          position = static_cast<std::uint64_t>(in.tellg());
+        if(position > header.degrees_offset)
+          throw snapshotException();
+      }
+      if(position != header.degrees_offset)
+        throw snapshotException();
+      in.seekg(header.degrees_offset);
+      in.read(reinterpret_cast<char*>(g._out_degree), n * sizeof(size_type));
+      in.read(reinterpret_cast<char*>(g._in_degree), n * sizeof(size_type));
+      if(!in)
+        throw snapshotException();
+
+      bool mapped = false;
+      if constexpr (S::mappable){
+        if(header.adjacency_size != S().image_size(n))
+          throw snapshotException();
+        storage_mapping mapping;
+        if(map && mapping.map(path.c_str(), header.adjacency_offset, header.adjacency_size)){
+          S storage;
+          storage.adopt(mapping, n);
+          g._storage.swap(storage);
+          mapped = true;
+        }
+      }
+      if(!mapped){
+        S storage(n);
+        in.seekg(header.adjacency_offset);
+        if(!storage.read_image(in, n, header.edges))
+          throw snapshotException();
+        g._storage.swap(storage);
+      }
+
+      //the counters must be the ones of the adjacency, which must only hold edges
+      if(!g._storage.valid_image(n))
+        throw snapshotException();
+      std::vector<size_type> out_degree(n), in_degree(n);
+      g._storage.degrees(n, out_degree.data(), in_degree.data());
+      std::uint64_t edges = 0;
+      for(size_type i=0; i<n; i++){
+        if(out_degree[i] != g._out_degree[i] || in_degree[i] != g._in_degree[i])
+          throw snapshotException();
+        edges += out_degree[i];
+      }
+      if(edges != header.edges)
+        throw snapshotException();
+
+      g._size = n;
+      g._edges = header.edges;
+      g._reallocate_index(_buckets_for(n));
+      if(header.flags & snapshot_acyclic){
+        try{
+          g.setAcyclic(true);
+        }
+        catch(cycleException &e){
+          throw snapshotException();
+        }
+      }
+      return g;
+    }
+
+    /**
+     * @brief build a graph from a text edge list, see ograph_edgelist.hpp
+     *
+     * The stream is read in blocks of chunk bytes. The blocks are parsed
+     * by a team of threads, one block per thread, and the labels are then
+     * given positions in order of appearance. The graph is built once all
+     * the edges are read, with a single allocation of the graph data.
+     * The memory used is the graph, the positions of the edges, and a
+     * block per thread.
+     *
+     * The labels are hashed with H, or with std::hash when the graph
+     * has no hash index. With weights, a line without the weight field
+     * has the unit weight. Without weights, the weight field is ignored.
+     *
+     * @param in the stream
+     * @param threads the amount of threads, 0 to use all the cores
+     * @param parser the label parser, edge_list_labels parses numbers
+     * @param chunk the size of the blocks
+     * @return the graph
+     * @throw edgeListException a line is not valid
+     * @throw invalidEdgeException an edge appears twice in the list
+     * @throw std::bad_alloc
+     */
+    template <typename P = edge_list_labels<T> >
+    static oriented_graph readEdgeList(std::istream &in, unsigned threads = 0, const P &parser = P(), std::size_t chunk = edge_list_chunk){
+      typedef typename std::conditional<_hashed, H, std::hash<T> >::type label_hash;
+      edge_list_interner<T, label_hash, E> interner;
+      std::vector<size_type> from, to;
+      std::vector<weight_type> weights;
+
+      const unsigned team_size = parallel_threads(threads);
+      parallel_team team(team_size);
+      edge_list_reader reader(in, chunk);
+      std::vector<std::vector<char> > blocks(team_size);
+      std::vector<std::vector<T> > labels(team_size);
+      std::vector<std::vector<weight_type> > block_weights(team_size);
+      std::vector<unsigned char> valid(team_size);
+      bool more = true;
+      while(more){
+        unsigned used = 0;
+        while(used < team_size && (more = reader.next(blocks[used])))
+          used++;
+        team.run([&](unsigned t){
+          labels[t].clear();
+          block_weights[t].clear();
+          valid[t] = t >= used || edge_list_parse(blocks[t].data(), blocks[t].data() + blocks[t].size(),
+            parser, _weighted, _unit_weight(), labels[t], block_weights[t]);
+        });
+
+        //the positions are given in the order of the blocks, as in a serial parse
+        for(unsigned t=0; t<used; t++){
+          if(!valid[t])
+            throw edgeListException();
+          for(std::size_t l=0; l<labels[t].size(); l+=2){
+            from.push_back(interner.intern(std::move(labels[t][l])));
+            to.push_back(interner.intern(std::move(labels[t][l+1])));
+          }
+          weights.insert(weights.end(), block_weights[t].begin(), block_weights[t].end());
+        }
+      }
+
+      oriented_graph g;
+      g._load_distinct(interner.labels());
+      g._assign_edges(from, to, weights);
+      return g;
+    }
+
+    /**
+     * @brief check if a node is part of the graph
+     *
+     * @returns true the node exists
+     * @returns false the node does not exist
+     */
+    bool existsNode(const T &node) const{
+      return (_index(node) != -1);
+    }
+
+    /**
+     * @brief the id of a node, to use in the calls that take a node_id
+     *
+     * @param node the label of the node
+     * @return the id, valid until a node is removed from the graph
+     * @throw invalidNodeException the provided node does not exist
+     */
+    node_id nodeId(const T &node) const{
+      const int i = _index(node);
+      if(i == -1)
+        throw invalidNodeException();
+      return _id(i);
+    }
+
+    /**
+     * @brief the label of a node, given by id
+     *
+     * @throw invalidNodeException the id is not the position of a node
+     */
+    const T& label(node_id node) const{
+      return _nodes[_position(node)];
+    }
+
+    /**
+     * @brief check if an edge is part of the graph
+     *
+     * This implementation considers invalid nodes to be a valid query,
+     * therefore providing an invalid node will not raies any exception
+     *  
+     * @param nodeFrom the start node
      * @param nodeTo the end node
      * @returns true the edge exist
      * @returns false the edge does not exist, or one of the two nodes does not exist
@@ -332,163 +2473,929 @@ class oriented_graph {
       int iTo = _index(nodeTo);
       if(iFrom == -1 || iTo == -1)
         return false;
-      return (_matrix[iFrom][iTo] != 0);
+      return _storage.test(iFrom, iTo);
+    }
+
+    /**
+     * @brief check if an edge is part of the graph, given the ids of its nodes
+     *
+     * @returns true the edge exist
+     * @returns false the edge does not exist, or an id is not the position of a node
+     */
+    bool existsEdge(node_id from, node_id to) const{
+      if(!_valid(from) || !_valid(to))
+        return false;
+      return _storage.test(from._position, to._position);
+    }
+
+    /**
+     * @brief the weight of an edge
+     *
+     * Only available when the storage keeps weights.
+     *
+     * @param nodeFrom the start node
+     * @param nodeTo the end node
+     * @throw invalidEdgeException the edge does not exist, or one of the two nodes does not exist
+     * @return the weight given to the edge when it was added
+     */
+    weight_type weight(const T &nodeFrom, const T &nodeTo) const{
+      static_assert(_weighted, "the storage policy has no edge weights");
+      int iFrom = _index(nodeFrom);
+      int iTo = _index(nodeTo);
+      if(iFrom == -1 || iTo == -1 || !_storage.test(iFrom, iTo))
+        throw invalidEdgeException();
+      return _storage.weight(iFrom, iTo);
+    }
+
+    /**
+     * @brief breadth first visit of the nodes reachable from a node
+     *
+     * The visit works on the node positions, with a bitset of the
+     * visited nodes and a queue allocated once, and costs O(n + e)
+     * on sparse_storage, O(n^2) on the matrix storages.
+     *
+     * @param node the first node of the visit
+     * @param visit functor called with the label of every reached node,
+     *   starting from node. When it returns a bool, the visit stops as
+     *   soon as it returns true
+     * @throw invalidNodeException the provided node does not exist
+     * @throw std::bad_alloc
+     */
+    template <typename Visitor>
+    void bfs(const T &node, Visitor visit) const{
+      const int start = _index(node);
+      if(start == -1)
+        throw invalidNodeException();
+      _bfs(start, [&](size_type i){ return _call_visitor(visit, _nodes[i]); });
+    }
+
+    /**
+     * @brief depth first visit of the nodes reachable from a node
+     *
+     * The nodes are visited in preorder. The visit is iterative, so deep
+     * graphs do not overflow the call stack. Same costs as bfs()
+     *
+     * @param node the first node of the visit
+     * @param visit functor called with the label of every reached node,
+     *   starting from node. When it returns a bool, the visit stops as
+     *   soon as it returns true
+     * @throw invalidNodeException the provided node does not exist
+     * @throw std::bad_alloc
+     */
+    template <typename Visitor>
+    void dfs(const T &node, Visitor visit) const{
+      const int start = _index(node);
+      if(start == -1)
+        throw invalidNodeException();
+      _dfs(start, [&](size_type i){ return _call_visitor(visit, _nodes[i]); });
+    }
+
+    /**
+     * @brief breadth first visit with many threads, for large graphs
+     *
+     * Switches between top-down and bottom-up steps depending on the size
+     * of the frontier, see _parallel_bfs. The bottom-up steps walk the
+     * predecessor columns, so they are fast on sparse_storage.
+     * The result does not depend on the amount of threads: the visitor is
+     * called on the calling thread, level by level, and in each level
+     * in the order of the node positions.
+     *
+     * @param node the first node of the visit
+     * @param visit functor called with the label and the depth of every
+     *   reached node, starting from node at depth 0
+     * @param threads the amount of threads, 0 to use all the cores
+     * @throw invalidNodeException the provided node does not exist
+     * @throw std::bad_alloc
+     * @throw std::system_error a thread could not be started
+     */
+    template <typename Visitor>
+    void parallelBfs(const T &node, Visitor visit, unsigned threads = 0) const{
+      const int start = _index(node);
+      if(start == -1)
+        throw invalidNodeException();
+      _parallel_bfs(start, threads, [&](size_type i, size_type depth){ visit(_nodes[i], depth); });
+    }
+
+    /**
+     * @brief the nodes reachable from a node, in breadth first order
+     *
+     * @param node the start node, the first of the result
+     * @return the labels of the reachable nodes
+     * @throw invalidNodeException the provided node does not exist
+     * @throw std::bad_alloc
+     */
+    std::vector<T> reachableFrom(const T &node) const{
+      std::vector<T> reached;
+      bfs(node, [&](const T &n){ reached.push_back(n); });
+      return reached;
+    }
+
+    /**
+     * @brief check if there is a path between two nodes
+     *
+     * The visit stops as soon as the end node is reached.
+     * Every node has an empty path to itself
+     *
+     * @param nodeFrom the start node
+     * @param nodeTo the end node
+     * @returns true there is a path from nodeFrom to nodeTo
+     * @returns false there is no path
+     * @throw invalidNodeException the provided nodes do not exist
+     * @throw std::bad_alloc
+     */
+    bool hasPath(const T &nodeFrom, const T &nodeTo) const{
+      const int from = _index(nodeFrom);
+      const int to = _index(nodeTo);
+      if(from == -1 || to == -1)
+        throw invalidNodeException();
+      const size_type target = to;
+      return _bfs(from, [&](size_type i){ return i == target; });
+    }
+
+    /**
+     * @brief the shortest paths from a node to all the other nodes
+     *
+     * Without weights, or when every edge reached from the source has
+     * weight 1, the paths are found with a breadth first search.
+     * Otherwise with Dijkstra's algorithm, which needs an arithmetic
+     * weight type and non negative weights: on a radix heap for integer
+     * weights, on a 4-ary heap for the others. The search only uses the
+     * buffers of paths, so repeated queries on a graph of the same size
+     * allocate nothing. Costs O(n + e) for the breadth first search and
+     * O(e + n log n) for Dijkstra on sparse_storage; the matrix storages
+     * add O(n^2) for the row scans.
+     *
+     * @param source the start node
+     * @param paths filled with the distance and the parent of every node.
+     *   The distances are the sums of the weights, so they must not overflow
+     *   distance_type
+     * @throw invalidNodeException the provided node does not exist
+     * @throw invalidEdgeException a reached edge has a negative weight
+     * @throw std::bad_alloc the buffers of paths could not grow
+     */
+    void shortestPaths(const T &source, shortest_paths &paths) const{
+      static_assert(!_weighted || std::is_arithmetic<weight_type>::value,
+        "shortest paths need an arithmetic weight type");
+      const int start = _index(source);
+      if(start == -1)
+        throw invalidNodeException();
+      paths._reset(_size);
+      if constexpr (_weighted){
+        if(!_unit_paths(start, paths)){
+          paths._reset(_size);
+          if constexpr (std::is_integral<weight_type>::value)
+            _radix_paths(start, paths);
+          else
+            _weighted_paths(start, paths);
+        }
+      }
+      else
+        _unit_paths(start, paths);
+    }
+
+    /**
+     * @brief the shortest paths from a node, with new buffers
+     *
+     * @param source the start node
+     * @return the distance and the parent of every node
+     * @throw invalidNodeException the provided node does not exist
+     * @throw invalidEdgeException a reached edge has a negative weight
+     * @throw std::bad_alloc
+     */
+    shortest_paths shortestPaths(const T &source) const{
+      shortest_paths paths;
+      shortestPaths(source, paths);
+      return paths;
+    }
+
+    /**
+     * @brief the shortest paths between all the pairs of nodes
+     *
+     * Floyd-Warshall's algorithm on a dense matrix, in square tiles of
+     * 64 nodes. For every block of pivots the diagonal tile is closed
+     * first, then the tiles in its row and column, then all the other
+     * tiles, which only read the tiles of the first two steps. So the
+     * tiles of a step are independent and are split across the threads,
+     * and every update works on three tiles that stay in cache. The row
+     * updates use the SIMD kernels for the 32 and 64 bit integer distances.
+     *
+     * Without weights the distances count the edges. The weights must be
+     * non negative, and the distances must stay below half the largest
+     * value of distance_type. Costs O(n^3) time and O(n^2) memory.
+     *
+     * @param threads the amount of threads, 0 to use all the cores
+     * @return the matrix of the distances
+     * @throw invalidEdgeException an edge has a negative weight
+     * @throw std::bad_alloc
+     * @throw std::system_error a thread could not be started
+     */
+    distance_matrix allPairsShortestPaths(unsigned threads = 0) const{
+      static_assert(!_weighted || std::is_arithmetic<weight_type>::value,
+        "shortest paths need an arithmetic weight type");
+      const size_type tile = 64;
+      const distance_type infinity = _path_infinity();
+      distance_matrix result;
+      result._size = _size;
+      result._stride = storage_stride_for<distance_type>(_size);
+      result._cells = storage_new_cells<distance_type>(_size * result._stride);
+      distance_type* d = result._cells;
+      const std::size_t stride = result._stride;
+
+      for(size_type i=0; i<_size; i++){
+        std::fill(d + i * stride, d + i * stride + _size, infinity);
+        _storage.each_out(i, _size, [&](size_type j, const weight_type &w){
+          if constexpr (_weighted){
+            if(w < weight_type(0))
+              throw invalidEdgeException();
+            d[i * stride + j] = w;
+          }
+          else
+            d[i * stride + j] = 1;
+        });
+        d[i * stride + i] = 0;
+      }
+
+      const size_type blocks = (_size + tile - 1) / tile;
+      auto extent = [&](size_type b){ return std::min(tile, _size - b * tile); };
+      parallel_team team(parallel_threads(threads));
+      for(size_type kb=0; kb<blocks; kb++){
+        const size_type k0 = kb * tile;
+        const size_type depth = extent(kb);
+        _relax_tile(d, stride, k0, depth, k0, depth, k0, depth);
+
+        //the tiles of the pivot row and column, 2 (blocks - 1) of them
+        std::atomic<size_type> cursor(0);
+        team.run([&](unsigned){
+          for(size_type t = cursor.fetch_add(1, std::memory_order_relaxed); t < 2*blocks;
+              t = cursor.fetch_add(1, std::memory_order_relaxed)){
+            const size_type b = t / 2;
+            if(b == kb)
+              continue;
+            if(t % 2 == 0)
+              _relax_tile(d, stride, k0, depth, b * tile, extent(b), k0, depth);
+            else
+              _relax_tile(d, stride, b * tile, extent(b), k0, depth, k0, depth);
+          }
+        });
+
+        //all the other tiles, a row of tiles at a time
+        cursor = 0;
+        team.run([&](unsigned){
+          for(size_type ib = cursor.fetch_add(1, std::memory_order_relaxed); ib < blocks;
+              ib = cursor.fetch_add(1, std::memory_order_relaxed)){
+            if(ib == kb)
+              continue;
+            for(size_type jb=0; jb<blocks; jb++)
+              if(jb != kb)
+                _relax_tile(d, stride, ib * tile, extent(ib), jb * tile, extent(jb), k0, depth);
+          }
+        });
+      }
+
+      for(size_type i=0; i<_size; i++)
+        for(size_type j=0; j<_size; j++)
+          if(!(d[i * stride + j] < infinity))
+            d[i * stride + j] = distance_matrix::unreached;
+      return result;
+    }
+
+    /**
+     * @brief find the strongly connected components of the graph
+     *
+     * Iterative Tarjan's algorithm on the node positions: the depth
+     * first visit keeps its own stack, so the call stack does not grow
+     * with the depth of the graph. Costs O(n + e) on sparse_storage,
+     * O(n^2) on the matrix storages.
+     *
+     * The components are numbered in topological order: when there
+     * is an edge from a node of component a to a node of component b,
+     * with a != b, then a < b.
+     *
+     * @return the component of every node, in the order in which
+     *   const_iterator yields the nodes
+     * @throw std::bad_alloc
+     */
+    std::vector<size_type> stronglyConnectedComponents() const{
+      const size_type unvisited = static_cast<size_type>(-1);
+      std::vector<size_type> component(_size, unvisited);
+      std::vector<size_type> order(_size, unvisited), low(_size);
+      std::vector<size_type> stack, path, resume;
+      stack.reserve(_size);
+      path.reserve(_size);
+      resume.reserve(_size);
+      size_type visited = 0, found = 0;
+
+      for(size_type root=0; root<_size; root++){
+        if(order[root] != unvisited)
+          continue;
+        order[root] = low[root] = visited++;
+        stack.push_back(root);
+        path.push_back(root);
+        resume.push_back(0);
+        while(!path.empty()){
+          const size_type i = path.back();
+          const size_type j = _storage.next_out(i, resume.back(), _size);
+          if(j < _size){
+            resume.back() = j+1;
+            if(order[j] == unvisited){
+              order[j] = low[j] = visited++;
+              stack.push_back(j);
+              path.push_back(j);
+              resume.push_back(0);
+            }
+            else if(component[j] == unvisited)
+              low[i] = std::min(low[i], order[j]);
+            continue;
+          }
+          //all the successors of i are done
+          path.pop_back();
+          resume.pop_back();
+          if(!path.empty())
+            low[path.back()] = std::min(low[path.back()], low[i]);
+          if(low[i] == order[i]){
+            size_type k;
+            do{
+              k = stack.back();
+              stack.pop_back();
+              component[k] = found;
+            } while(k != i);
+            found++;
+          }
+        }
+      }
+
+      //Tarjan's algorithm completes the components in reverse topological order
+      for(size_type i=0; i<_size; i++)
+        component[i] = found-1 - component[i];
+      return component;
+    }
+
+    /**
+     * @brief the condensation of the graph
+     *
+     * The condensation has a node for every strongly connected component,
+     * labelled with the component id of stronglyConnectedComponents(),
+     * and an edge from a to b when an edge of this graph goes from
+     * component a to component b != a. It is always acyclic.
+     *
+     * @return the condensation graph
+     * @throw std::bad_alloc
+     */
+    condensation_type condensation() const{
+      const std::vector<size_type> component = stronglyConnectedComponents();
+      size_type count = 0;
+      for(size_type i=0; i<_size; i++)
+        count = std::max(count, component[i]+1);
+
+      std::vector<size_type> ids(count);
+      for(size_type c=0; c<count; c++)
+        ids[c] = c;
+      std::vector<std::pair<size_type, size_type> > links;
+      for(size_type i=0; i<_size; i++)
+        for(size_type j=_storage.next_out(i, 0, _size); j<_size; j=_storage.next_out(i, j+1, _size))
+          if(component[i] != component[j])
+            links.push_back(std::make_pair(component[i], component[j]));
+      std::sort(links.begin(), links.end());
+      links.erase(std::unique(links.begin(), links.end()), links.end());
+      return condensation_type(ids.begin(), ids.end(), links.begin(), links.end());
+    }
+
+    /**
+     * @brief the nodes of the graph in a topological order
+     *
+     * In a topological order, the start node of every edge comes before
+     * its end node. In acyclic mode the order is already maintained, and
+     * copied in O(n), otherwise it's computed in O(n + e) with Kahn's algorithm.
+     *
+     * @return the labels of the nodes, in topological order
+     * @throw cycleException the graph has a cycle
+     * @throw std::bad_alloc
+     */
+    std::vector<T> topologicalOrder() const{
+      std::vector<size_type> order;
+      if(_acyclic)
+        order = _ranked;
+      else if(!_topological_order(order))
+        throw cycleException();
+      std::vector<T> labels;
+      labels.reserve(_size);
+      for(size_type k=0; k<_size; k++)
+        labels.push_back(_nodes[order[k]]);
+      return labels;
+    }
+
+    /**
+     * @brief enable or disable the acyclic mode
+     *
+     * In acyclic mode addEdge and addEdges reject the edges that close
+     * a cycle, with a cycleException. The graph keeps a topological order
+     * of the nodes, updated at every insertion with the Pearce-Kelly
+     * algorithm, so the check only visits the nodes ranked between the
+     * two ends of the new edge.
+     * Provides the strong exception guarantee.
+     *
+     * @param acyclic true to enable the mode
+     * @throw cycleException the graph already has a cycle
+     * @throw std::bad_alloc
+     */
+    void setAcyclic(bool acyclic){
+      if(!acyclic){
+        _acyclic = false;
+        std::vector<size_type>().swap(_rank);
+        std::vector<size_type>().swap(_ranked);
+        std::vector<unsigned char>().swap(_mark);
+        return;
+      }
+      if(_acyclic)
+        return;
+      std::vector<size_type> order;
+      if(!_topological_order(order))
+        throw cycleException();
+      std::vector<size_type> rank(_size);
+      std::vector<unsigned char> mark(_size, 0);
+      for(size_type r=0; r<_size; r++)
+        rank[order[r]] = r;
+      _rank.swap(rank);
+      _ranked.swap(order);
+      _mark.swap(mark);
+      _acyclic = true;
+    }
+
+    /**
+     * @brief check if the graph is in acyclic mode, see setAcyclic
+     *
+     */
+    bool acyclic() const{
+      return _acyclic;
+    }
+
+    /**
+     * @brief the transitive closure of the graph
+     *
+     * The result has the same nodes, and an edge from a to b when there
+     * is a non-empty path from a to b in this graph.
+     *
+     * The closure is computed with Warshall's algorithm on a bit matrix,
+     * where a row update ORs 64 pairs per word, in blocks of 64 pivot nodes:
+     * the pivot rows of a block are closed first, then every other row is
+     * updated with the whole block, while the pivot rows are in cache.
+     * The other rows are independent, and are split across the threads.
+     * Costs O(n^3 / 64) time and O(n^2 / 8) bytes of memory.
+     *
+     * @param threads the amount of threads, 0 to use all the cores
+     * @return the closure
+     * @throw std::bad_alloc
+     * @throw std::system_error a thread could not be started
+     */
+    oriented_graph transitiveClosure(unsigned threads = 0) const{
+      //rows of updates handed to a thread at a time
+      const size_type chunk = 64;
+      const simd_kernels& simd = simd_dispatch();
+      const std::size_t words = (_size + 63) / 64;
+      _bitset reach(_size * words, 0);
+      auto row = [&](size_type i){ return reach.data() + i * words; };
+      for(size_type i=0; i<_size; i++)
+        for(size_type j=_storage.next_out(i, 0, _size); j<_size; j=_storage.next_out(i, j+1, _size))
+          row(i)[j / 64] |= std::uint64_t(1) << (j % 64);
+
+      parallel_team team(parallel_threads(threads));
+      for(std::size_t block=0; block<words; block++){
+        const size_type first = static_cast<size_type>(block * 64);
+        const size_type last = std::min(first + 64, _size);
+        for(size_type k=first; k<last; k++)
+          for(size_type i=first; i<last; i++)
+            if((row(i)[block] >> (k - first)) & 1)
+              simd.unite(row(i), row(k), words);
+
+        //the pivot rows already contain everything reachable through the block,
+        //so the bits added to a row by the block do not need a visit
+        std::atomic<size_type> cursor(0);
+        team.run([&](unsigned){
+          for(;;){
+            const size_type start = cursor.fetch_add(chunk, std::memory_order_relaxed);
+            if(start >= _size)
+              break;
+            const size_type end = std::min(start + chunk, _size);
+            for(size_type i=start; i<end; i++){
+              if(i >= first && i < last)
+                continue;
+              for(std::uint64_t bits = row(i)[block]; bits != 0; bits &= bits - 1)
+                simd.unite(row(i), row(first + __builtin_ctzll(bits)), words);
+            }
+          }
+        });
+      }
+
+      oriented_graph closure;
+      closure.reserve(_size);
+      for(size_type i=0; i<_size; i++)
+        closure._nodes[i] = _nodes[i];
+      closure._size = _size;
+      closure._rebuild_index();
+      for(size_type i=0; i<_size; i++)
+        for(std::size_t w=0; w<words; w++)
+          for(std::uint64_t bits = row(i)[w]; bits != 0; bits &= bits - 1){
+            const size_type j = static_cast<size_type>(w * 64 + __builtin_ctzll(bits));
+            closure._storage.set(i, j, _unit_weight());
+            closure._out_degree[i]++;
+            closure._in_degree[j]++;
+            closure._edges++;
+          }
+      return closure;
     }
 
     /**
      * @brief add a node to the graph
      *
+     * When the graph is full its capacity is doubled, so that
+     * inserting n nodes costs amortized constant time per node.
+     * Provides the strong exception guarantee.
+     *
      * @param node node to add to the graph
      * @throw invalidNodeException the provided node already exist
      * @throw std::bad_alloc 
+     * @return the id of the new node
      * @post _size = _size+1
-     * @post _nodes != _nodes
-     * @post _matrix != _matrix
      */
-    void addNode(const T &node){
-      if(existsNode(node))
+    node_id addNode(const T &node){
+      return _id(_add_node(node));
+    }
+
+    /**
+     * @brief add a node to the graph, moving the label into it
+     *
+     * Same as addNode(const T&), but the label is moved instead of copied.
+     * When an exception is thrown the graph is unchanged, and node is
+     * left untouched, unless the move assignment of T threw.
+     *
+     * @param node node to add to the graph
+     * @throw invalidNodeException the provided node already exist
+     * @throw std::bad_alloc 
+     * @return the id of the new node
+     * @post _size = _size+1
+     */
+    node_id addNode(T &&node){
+      return _id(_add_node(std::move(node)));
+    }
+
+    /**
+     * @brief add a node to the graph, building its label from the given arguments
+     *
+     * The label is built once, then moved into the graph.
+     * Provides the strong exception guarantee.
+     *
+     * @param args the arguments of a constructor of T
+     * @throw invalidNodeException the node already exist
+     * @throw std::bad_alloc 
+     * @throw any exception thrown by the constructor of T
+     * @return the id of the new node
+     * @post _size = _size+1
+     */
+    template <typename... Args>
+    node_id emplaceNode(Args&&... args){
+      return _id(_add_node(T(std::forward<Args>(args)...)));
+    }
+
+    /**
+     * @brief remove a node from the graph
+     *
+     * The last node of the graph is moved in the position of the removed
+     * node, so the removal costs O(n) time and never allocates.
+     * This changes the order in which const_iterator yields the nodes.
+     * The capacity of the graph does not change.
+     * Provides the strong exception guarantee if the copy assignment of T does.
+     *
+     * @param node node to remove from the graph
+     * @throw invalidNodeException the provided node does not exist
+     * @post _size = _size-1
+     */
+    void removeNode(const T &node){
+      const int index = _index(node);
+      if(index == -1)
+        throw invalidNodeException();
+
+      const size_type k = index;
+      const size_type last = _size-1;
+      size_type k_bucket = 0, last_bucket = 0;
+      if constexpr (_hashed){
+        k_bucket = _bucket_of(k);
+        last_bucket = _bucket_of(last);
+      }
+
+      //move the last node in the freed position. This is the only step that can throw
+      if(k != last)
+        _transfer(_nodes[k], _nodes[last]);
+
+      //the neighbours of the removed node lose an edge each
+      for(size_type j=_storage.next_out(k, 0, _size); j<_size; j=_storage.next_out(k, j+1, _size))
+        if(j != k)
+          _in_degree[j]--;
+      for(size_type i=_storage.next_in(k, 0, _size); i<_size; i=_storage.next_in(k, i+1, _size))
+        if(i != k)
+          _out_degree[i]--;
+      _edges -= _out_degree[k] + _in_degree[k] - (_storage.test(k, k) ? 1 : 0);
+
+      _storage.remove(k, _size);
+      _out_degree[k] = _out_degree[last];
+      _in_degree[k] = _in_degree[last];
+      _out_degree[last] = 0;
+      _in_degree[last] = 0;
+
+      //close the gap in the topological order, then follow the moved node
+      if(_acyclic){
+        for(size_type r=_rank[k]; r<last; r++){
+          _ranked[r] = _ranked[r+1];
+          _rank[_ranked[r]] = r;
+        }
+        if(k != last){
+          _rank[k] = _rank[last];
+          _ranked[_rank[k]] = k;
+        }
+        _rank.pop_back();
+        _ranked.pop_back();
+        _mark.pop_back();
+      }
+      _size = last;
+      _epoch = _new_epoch();
+
+      if constexpr (_hashed){
+        _buckets[last_bucket] = k;
+        _index_erase(k_bucket);
+      }
+    }
+
+    /**
+     * @brief add a direct edge between two nodes
+     *
+     * @param nodeFrom the start node
+     * @param nodeTo the destination node
+     * @param w the weight of the edge, ignored when the storage has no weights.
+     *   1 by default, when the weight type can be built from an int
+     * @throw invalidEdgeException the edge already exists
+     * @throw cycleException the graph is in acyclic mode, and the edge closes a cycle
+     * @throw invalidNodeException the provided nodes do not exist
+     * @throw std::bad_alloc the storage is sparse_storage, and could not grow,
+     *   or the graph is in acyclic mode
+     * @post _storage.test(i, j) != _storage.test(i, j)
+     */
+    void addEdge(const T &nodeFrom, const T &nodeTo, const weight_type &w = _unit_weight()){
+      const int iFrom = _index(nodeFrom);
+      const int iTo = _index(nodeTo);
+      if(iFrom == -1 || iTo == -1)
         throw invalidNodeException();
+      _add_edge(iFrom, iTo, w);
+    }
+
+    /**
+     * @brief add a direct edge between two nodes, given by id
+     *
+     * Same as addEdge with the labels, without any label lookup.
+     *
+     * @param from the start node
+     * @param to the destination node
+     * @param w the weight of the edge, ignored when the storage has no weights
+     * @throw invalidEdgeException the edge already exists
+     * @throw cycleException the graph is in acyclic mode, and the edge closes a cycle
+     * @throw invalidNodeException an id is not the position of a node
+     * @throw std::bad_alloc the storage is sparse_storage, and could not grow,
+     *   or the graph is in acyclic mode
+     */
+    void addEdge(node_id from, node_id to, const weight_type &w = _unit_weight()){
+      _add_edge(_position(from), _position(to), w);
+    }
+
+    /**
+     * @brief remove an existing direct edge between two nodes
+     *
+     * @param nodeFrom the start node
+     * @param nodeTo the destination node
+     * @throw invalidEdgeException the edge does not exist
+     * @post _storage.test(i, j) != _storage.test(i, j)
+     */
+    void removeEdge(const T &nodeFrom, const T &nodeTo){
+      const int iFrom = _index(nodeFrom);
+      const int iTo = _index(nodeTo);
+      if(iFrom == -1 || iTo == -1)
+        throw invalidEdgeException();
+      _remove_edge(iFrom, iTo);
+    }
+
+    /**
+     * @brief remove an existing direct edge between two nodes, given by id
+     *
+     * @param from the start node
+     * @param to the destination node
+     * @throw invalidEdgeException the edge does not exist, or an id is not
+     *   valid, like the overload that takes the labels
+     */
+    void removeEdge(node_id from, node_id to){
+      if(!_valid(from) || !_valid(to))
+        throw invalidEdgeException();
+      _remove_edge(from._position, to._position);
+    }
+
+    /**
+     * @brief add many nodes to the graph
+     *
+     * The graph is reallocated at most once. Provides the strong
+     * exception guarantee: if one of the nodes is invalid, no node is added.
+     *
+     * @param first the start of the node range
+     * @param last the end of the node range
+     * @throw invalidNodeException a node already exists, or appears twice in the range
+     * @throw std::bad_alloc 
+     * @post _size = _size + the length of the range
+     */
+    template <typename NodeIt>
+    void addNodes(NodeIt first, NodeIt last){
+      const size_type old_size = _size;
+      const size_type count = static_cast<size_type>(std::distance(first, last));
+      _grow(old_size + count);
+      const size_type bucket_count = _buckets_for(old_size + count);
+      if(bucket_count > _bucket_count)
+        _reallocate_index(bucket_count);
+      if(_acyclic){
+        _rank.reserve(old_size + count);
+        _ranked.reserve(old_size + count);
+        _mark.reserve(old_size + count);
+      }
 
-      //create new, larger data structures
-      size_type new_size = _size+1;
-      T* new_nodes = nullptr;
-      int** new_matrix = nullptr;
       try{
-        new_nodes = new T[new_size];
-        new_matrix = new int*[new_size];
-        _init_matrix(new_matrix, new_size);
-        // throw std::bad_alloc(); //TODO:remove. decomment to simulate malloc issue
-        for(size_type i=0; i<new_size; i++)
-          new_matrix[i] = new int[new_size];
+        for(size_type i=old_size; i<old_size+count; ++i, ++first){
+          _nodes[i] = *first;
+          //_size grows with the nodes, so that lookups see the previous nodes of the range
+          _size = i;
+          if(existsNode(_nodes[i]))
+            throw invalidNodeException();
+          if constexpr (_hashed)
+            _index_insert(i);
+        }
       }
       catch(...){
         #ifndef NDEBUG 
-        std::cout<<"exception in addNode()"<<std::endl;
+        std::cout<<"exception in addNodes()"<<std::endl;
         #endif   
-        delete[] new_nodes;
-        _delete_matrix(new_matrix, new_size);
+        _size = old_size;
+        _rebuild_index();
         throw;
       }
-
-      //copy old data structures to new data structures
-      for(size_type i=0; i<_size; i++)
-        new_nodes[i] = _nodes[i];
-      for(size_type i=0; i<_size; i++)
-        for(size_type j=0; j<_size; j++)
-          new_matrix[i][j] = _matrix[i][j];
-
-      //add the new data
-      new_nodes[new_size-1] = node;
-      for(size_type i=0; i<new_size; i++){
-        new_matrix[i][new_size-1] = 0;
-        new_matrix[new_size-1][i] = 0;
-      }
-
-      //delete old data structures
-      _clear();
-
-      //commit
-      _size = new_size;
-      _nodes = new_nodes;
-      _matrix = new_matrix;
-
-      //TODO: should i std::swap and _then_ delete the new data?
+      _size = old_size + count;
+      //the new nodes have no edges, they go last in the topological order
+      if(_acyclic)
+        for(size_type i=old_size; i<_size; i++){
+          _rank.push_back(i);
+          _ranked.push_back(i);
+          _mark.push_back(0);
+        }
     }
 
     /**
-     * @brief remove a node from the graph
+     * @brief remove many nodes from the graph
      *
-     * @param node node to remove from the graph
-     * @throw invalidNodeException the provided node does not exist
+     * The matrix is compacted in a single pass, and only the node list
+     * is reallocated. Provides the strong exception guarantee: if one
+     * of the nodes is invalid, no node is removed.
+     *
+     * @param first the start of the node range
+     * @param last the end of the node range
+     * @throw invalidNodeException a node does not exist, or appears twice in the range
      * @throw std::bad_alloc
-     * @post _size = _size-1
-     * @post _nodes != _nodes
-     * @post _matrix != _matrix
+     * @post _size = _size - the length of the range
      */
-    void removeNode(const T &node){
-      if(!existsNode(node))
-        throw invalidNodeException();
+    template <typename NodeIt>
+    void removeNodes(NodeIt first, NodeIt last){
+      //find the new position of the remaining nodes
+      std::vector<size_type> remap(_size, 0);
+      for(; first != last; ++first){
+        const int i = _index(*first);
+        if(i == -1 || remap[i] == storage_removed)
+          throw invalidNodeException();
+        remap[i] = storage_removed;
+      }
+      size_type new_size = 0;
+      for(size_type i=0; i<_size; i++)
+        if(remap[i] != storage_removed)
+          remap[i] = new_size++;
+      if(new_size == _size)
+        return;
 
-      //create new, smaller data structures
-      const size_type new_size = _size-1;
+      //create a new node list, without the removed nodes,
+      //and the topological order of the remaining nodes
       T* new_nodes = nullptr;
-      int** new_matrix = nullptr;
+      std::vector<size_type> new_rank, new_ranked;
       try{
-        new_nodes = new T[new_size];
-        new_matrix = new int*[new_size];
-        _init_matrix(new_matrix, new_size);
-        for(size_type i=0; i<new_size; i++)
-          new_matrix[i] = new int[new_size];
+        new_nodes = new T[_capacity];
+        if(_acyclic){
+          new_rank.resize(new_size);
+          new_ranked.reserve(new_size);
+          for(size_type r=0; r<_size; r++)
+            if(remap[_ranked[r]] != storage_removed){
+              new_rank[remap[_ranked[r]]] = static_cast<size_type>(new_ranked.size());
+              new_ranked.push_back(remap[_ranked[r]]);
+            }
+        }
+        //last, so that nothing can throw after the labels are moved
+        for(size_type i=0; i<_size; i++)
+          if(remap[i] != storage_removed)
+            _transfer(new_nodes[remap[i]], _nodes[i]);
       }
       catch(...){
         #ifndef NDEBUG 
-        std::cout<<"exception in removeNode()"<<std::endl;
+        std::cout<<"exception in removeNodes()"<<std::endl;
         #endif   
         delete[] new_nodes;
-        _delete_matrix(new_matrix, new_size);
         throw;
       }
 
-      //copy old data structures to new data structures
-      const size_type skip_index = _index(node);
-      for(size_type i=0, new_i=0; i<_size; i++){
-        if(i == skip_index)
-          continue;
-        new_nodes[new_i] = _nodes[i];
-        for(size_type j=0, new_j=0; j<_size; j++){
-          if(j == skip_index)
-            continue;
-          new_matrix[new_i][new_j] = _matrix[i][j];
-          new_j++;
-        }
-        new_i++;
-      }
-
-      //delete old data structures
-      _clear();
+      _storage.compact(remap.data(), _size);
 
       //commit
+      delete[] _nodes;
+      const size_type old_size = _size;
       _size = new_size;
+      _epoch = _new_epoch();
       _nodes = new_nodes;
-      _matrix = new_matrix;
+      if(_acyclic){
+        _rank.swap(new_rank);
+        _ranked.swap(new_ranked);
+        _mark.resize(new_size);
+      }
+      _recount(old_size);
+      _rebuild_index();
     }
 
     /**
-     * @brief add a direct edge between two nodes
+     * @brief add many edges to the graph
      *
-     * @param nodeFrom the start node
-     * @param nodeTo the destination node
-     * @throw invalidEdgeException the edge already exists
-     * @throw invalidNodeException the provided nodes do not exist
-     * @post _matrix[i][j] != _matrix[i][j]
+     * Provides the strong exception guarantee: if one of the edges
+     * is invalid, no edge is added. The edges get the default weight,
+     * like addEdge without a weight.
+     *
+     * @param first the start of the edge range. The edges
+     *   have first and second members with the labels of the
+     *   start and end node, like std::pair<T, T>
+     * @param last the end of the edge range
+     * @throw invalidNodeException an edge refers to a node that does not exist
+     * @throw invalidEdgeException an edge already exists, or appears twice in the range
+     * @throw cycleException the graph is in acyclic mode, and the edges close a cycle
+     * @throw std::bad_alloc
      */
-    void addEdge(const T &nodeFrom, const T &nodeTo){
-      if(!existsNode(nodeFrom) || !existsNode(nodeTo))
-        throw invalidNodeException();
-      if(existsEdge(nodeFrom, nodeTo))
-        throw invalidEdgeException();
-
-      int weight = 1;
-      int iFrom = _index(nodeFrom);
-      int iTo = _index(nodeTo);
-      _matrix[iFrom][iTo] = weight;
+    template <typename EdgeIt>
+    void addEdges(EdgeIt first, EdgeIt last){
+      const std::vector<std::pair<size_type, size_type> > edges = _sorted_edges(first, last);
+      for(std::size_t e=0; e<edges.size(); e++)
+        if(_storage.test(edges[e].first, edges[e].second))
+          throw invalidEdgeException();
+
+      std::size_t e = 0;
+      try{
+        //a topological order stays valid after the rollback, since it has less edges
+        for(; e<edges.size(); e++){
+          if(_acyclic && !_order_edge(edges[e].first, edges[e].second))
+            throw cycleException();
+          _storage.set(edges[e].first, edges[e].second, _unit_weight());
+        }
+      }
+      catch(...){
+        while(e > 0){
+          e--;
+          _storage.reset(edges[e].first, edges[e].second);
+        }
+        throw;
+      }
+      for(e=0; e<edges.size(); e++){
+        _out_degree[edges[e].first]++;
+        _in_degree[edges[e].second]++;
+      }
+      _edges += edges.size();
     }
 
     /**
-     * @brief remove an existing direct edge between two nodes
+     * @brief remove many edges from the graph
      *
-     * @param nodeFrom the start node
-     * @param nodeTo the destination node
-     * @throw invalidEdgeException the edge does not exist
-     * @post _matrix[i][j] != _matrix[i][j]
+     * Provides the strong exception guarantee: if one of the edges
+     * is invalid, no edge is removed.
+     *
+     * @param first the start of the edge range. The edges
+     *   have first and second members with the labels of the
+     *   start and end node, like std::pair<T, T>
+     * @param last the end of the edge range
+     * @throw invalidNodeException an edge refers to a node that does not exist
+     * @throw invalidEdgeException an edge does not exist, or appears twice in the range
+     * @throw std::bad_alloc
      */
-    void removeEdge(const T &nodeFrom, const T &nodeTo){
-      if(!existsEdge(nodeFrom, nodeTo))
-        throw invalidEdgeException();
-
-      int iFrom = _index(nodeFrom);
-      int iTo = _index(nodeTo);
-      _matrix[iFrom][iTo] = 0;
+    template <typename EdgeIt>
+    void removeEdges(EdgeIt first, EdgeIt last){
+      const std::vector<std::pair<size_type, size_type> > edges = _sorted_edges(first, last);
+      for(std::size_t e=0; e<edges.size(); e++)
+        if(!_storage.test(edges[e].first, edges[e].second))
+          throw invalidEdgeException();
+      for(std::size_t e=0; e<edges.size(); e++){
+        _storage.reset(edges[e].first, edges[e].second);
+        _out_degree[edges[e].first]--;
+        _in_degree[edges[e].second]--;
+      }
+      _edges -= edges.size();
     }
 
   //iterator implementation
@@ -621,6 +3528,323 @@ class oriented_graph {
       return const_iterator(_nodes+_size);
     }
 
+    /**
+     * @brief const forward iterator on the neighbours of a node
+     *
+     * Walks the row (successors) or the column (predecessors) of the node
+     * in the storage, in the order of the node positions.
+     * The iterator is invalidated by any change to the graph.
+     */
+    class neighbor_iterator {
+      //traits:
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef T                         value_type;
+      typedef ptrdiff_t                 difference_type;
+      typedef const T*                  pointer;
+      typedef const T&                  reference;
+
+      /**
+       * @brief base constructor
+       */
+      neighbor_iterator() : g(nullptr), node(0), pos(0), incoming(false) {}
+
+      /**
+       * @return a reference to the neighbour pointed by the iterator
+       */
+      reference operator*() const {
+        return g->_nodes[pos];
+      }
+
+      /**
+       * @return the address of the neighbour pointed by the iterator
+       */
+      pointer operator->() const {
+        return g->_nodes + pos;
+      }
+
+      /**
+       * @brief post increment operator
+       */
+      neighbor_iterator operator++(int) {
+        neighbor_iterator tmp(*this);
+        ++(*this);
+        return tmp;
+      }
+
+      /**
+       * @brief pre increment operator
+       */
+      neighbor_iterator& operator++() {
+        pos = _next(pos+1);
+        return *this;
+      }
+
+      /**
+       * @brief equality operator
+       */
+      bool operator==(const neighbor_iterator &other) const {
+        return (g == other.g && node == other.node && pos == other.pos && incoming == other.incoming);
+      }
+
+      /**
+       * @brief inequality operator
+       */
+      bool operator!=(const neighbor_iterator &other) const {
+        return !(*this == other);
+      }
+
+    private:
+      const oriented_graph *g;
+      size_type node;
+      size_type pos;
+      bool incoming;
+
+      friend class oriented_graph;
+
+      /**
+       * @brief iterator constructor
+       *
+       * this constructor can only be called by oriented_graph, that has
+       * been set as friend
+       *
+       * @param gg the graph
+       * @param nn the position of the node whose neighbours are visited
+       * @param pp the first position to consider
+       * @param in true to visit the predecessors, false for the successors
+       */
+      neighbor_iterator(const oriented_graph *gg, size_type nn, size_type pp, bool in) :
+        g(gg), node(nn), pos(pp), incoming(in) {
+        pos = _next(pos);
+      }
+
+      /**
+       * @brief the position of the first neighbour from position p, or the graph size
+       */
+      size_type _next(size_type p) const {
+        if(incoming)
+          return g->_storage.next_in(node, p, g->_size);
+        return g->_storage.next_out(node, p, g->_size);
+      }
+
+    }; //class neighbor_iterator
+
+    /**
+     * @brief a range of neighbours, usable in a range based for
+     *
+     */
+    class neighbor_range {
+    public:
+      neighbor_iterator begin() const {
+        return _begin;
+      }
+
+      neighbor_iterator end() const {
+        return _end;
+      }
+
+    private:
+      neighbor_iterator _begin;
+      neighbor_iterator _end;
+
+      friend class oriented_graph;
+
+      neighbor_range(const neighbor_iterator &b, const neighbor_iterator &e) : _begin(b), _end(e) {}
+
+    }; //class neighbor_range
+
+    /**
+     * @brief the nodes reached by an edge from the given node
+     *
+     * Visiting the range costs O(n) on the matrix storages, where
+     * bit_storage skips the empty words, and O(degree) on sparse_storage.
+     *
+     * @param node the start node of the edges
+     * @return the range of the successors
+     * @throw invalidNodeException the provided node does not exist
+     */
+    neighbor_range successors(const T &node) const {
+      return _neighbors(node, false);
+    }
+
+    /**
+     * @brief the nodes with an edge towards the given node
+     *
+     * Visiting the range costs O(n) on the matrix storages,
+     * and O(degree) on sparse_storage.
+     *
+     * @param node the end node of the edges
+     * @return the range of the predecessors
+     * @throw invalidNodeException the provided node does not exist
+     */
+    neighbor_range predecessors(const T &node) const {
+      return _neighbors(node, true);
+    }
+
+    /**
+     * @brief const input iterator on the graph edges
+     *
+     * Yields the edges in row order: by position of the start node,
+     * then by position of the end node. Rows without edges are skipped
+     * in constant time with the out degree counters.
+     * Dereferencing returns the pair of labels by value, like the proxy
+     * reference of std::vector<bool>, so the iterator is tagged as an
+     * input iterator. It is still only a pair of positions: its copies
+     * walk the same edges, and the graph can be traversed many times.
+     * The iterator is invalidated by any change to the graph.
+     */
+    class edge_iterator {
+      //traits:
+    public:
+      typedef std::input_iterator_tag      iterator_category;
+      typedef std::pair<T, T>              value_type;
+      typedef ptrdiff_t                    difference_type;
+      typedef void                         pointer;
+      typedef std::pair<const T&, const T&> reference;
+
+      /**
+       * @brief base constructor
+       */
+      edge_iterator() : g(nullptr), i(0), j(0) {}
+
+      /**
+       * @return the labels of the start and end node of the edge
+       */
+      reference operator*() const {
+        return reference(g->_nodes[i], g->_nodes[j]);
+      }
+
+      /**
+       * @return the label of the start node of the edge
+       */
+      const T& from() const {
+        return g->_nodes[i];
+      }
+
+      /**
+       * @return the label of the end node of the edge
+       */
+      const T& to() const {
+        return g->_nodes[j];
+      }
+
+      /**
+       * @return the position of the start node of the edge
+       */
+      size_type from_index() const {
+        return i;
+      }
+
+      /**
+       * @return the position of the end node of the edge
+       */
+      size_type to_index() const {
+        return j;
+      }
+
+      /**
+       * @brief post increment operator
+       */
+      edge_iterator operator++(int) {
+        edge_iterator tmp(*this);
+        ++(*this);
+        return tmp;
+      }
+
+      /**
+       * @brief pre increment operator
+       */
+      edge_iterator& operator++() {
+        j = g->_storage.next_out(i, j+1, g->_size);
+        if(j == g->_size)
+          _next_row(i+1);
+        return *this;
+      }
+
+      /**
+       * @brief equality operator
+       */
+      bool operator==(const edge_iterator &other) const {
+        return (g == other.g && i == other.i && j == other.j);
+      }
+
+      /**
+       * @brief inequality operator
+       */
+      bool operator!=(const edge_iterator &other) const {
+        return !(*this == other);
+      }
+
+    private:
+      const oriented_graph *g;
+      size_type i;
+      size_type j;
+
+      friend class oriented_graph;
+
+      /**
+       * @brief iterator constructor
+       *
+       * this constructor can only be called by oriented_graph, that has
+       * been set as friend
+       *
+       * @param gg the graph
+       * @param row the first row to consider, the graph size for the end iterator
+       */
+      edge_iterator(const oriented_graph *gg, size_type row) : g(gg), i(0), j(0) {
+        _next_row(row);
+      }
+
+      /**
+       * @brief move to the first edge of the first non empty row from row r
+       *
+       * When there are no more edges, the iterator becomes the end iterator
+       */
+      void _next_row(size_type r) {
+        const size_type size = g->_size;
+        while(r < size && g->_out_degree[r] == 0)
+          r++;
+        i = r;
+        j = (r < size) ? g->_storage.next_out(r, 0, size) : size;
+      }
+
+    }; //class edge_iterator
+
+    /**
+     * @brief return an iterator pointing to the first edge in the graph
+     *
+     * Visiting all the edges costs O(n + e) on sparse_storage, and
+     * a single scan of the rows with edges on the matrix storages.
+     *
+     * @return edge_iterator iterator begin
+     */
+    edge_iterator edge_begin() const {
+      return edge_iterator(this, 0);
+    }
+
+    /**
+     * @brief return an iterator pointing to the end boundary of the edges
+     *
+     * @return edge_iterator iterator end
+     */
+    edge_iterator edge_end() const {
+      return edge_iterator(this, _size);
+    }
+
+  private:
+
+    /**
+     * @brief build the range of the successors or of the predecessors of a node
+     *
+     * @throw invalidNodeException the provided node does not exist
+     */
+    neighbor_range _neighbors(const T &node, bool incoming) const {
+      const int i = _index(node);
+      if(i == -1)
+        throw invalidNodeException();
+      return neighbor_range(neighbor_iterator(this, i, 0, incoming), neighbor_iterator(this, i, _size, incoming));
+    }
+
 };
 
 
@@ -0,0 +1,340 @@
+/**
+ * @file ograph_edgelist.hpp
+ * @brief streaming parser of the text edge lists
+ *
+ * An edge list has one edge per line: the label of the start node, the
+ * label of the end node and optionally the weight of the edge, separated
+ * by spaces or tabs. Empty lines and lines starting with # are skipped,
+ * and the lines may end with \r\n.
+ *
+ * The stream is read in blocks of whole lines of about a fixed size, so
+ * the memory used by the parser does not depend on the size of the file.
+ */
+
+#ifndef OGRAPH_EDGELIST_HPP
+#define OGRAPH_EDGELIST_HPP
+
+#include <charconv>  // std::from_chars
+#include <cstddef>   // std::size_t
+#include <istream>   // std::istream
+#include <string>    // std::string
+#include <system_error> // std::errc
+#include <type_traits> // std::is_arithmetic
+#include <utility>   // std::move
+#include <vector>    // std::vector
+#include "ograph_export.hpp"
+
+/**
+ * @brief default size of the blocks read from the stream
+ *
+ */
+constexpr std::size_t edge_list_chunk = 1 << 20;
+
+/**
+ * @brief parse a whole field as a number
+ *
+ * @return false when the field is not a number, or has trailing characters
+ */
+template <typename N>
+bool edge_list_number(const char* first, const char* last, N &number){
+  const std::from_chars_result result = std::from_chars(first, last, number);
+  return result.ec == std::errc() && result.ptr == last;
+}
+
+/**
+ * @brief default label parser, for arithmetic labels
+ *
+ * A label parser provides:
+ *  - parse(first, last, label), that fills label from the characters
+ *    of a field and returns false when the field is not a valid label
+ *  - format(out, label), that writes the label to an export_buffer
+ *    as a single field, in the form read by parse
+ *  - text(out, label), that writes the label as plain text, for the
+ *    exports that quote the labels themselves, like DOT
+ */
+template <typename T>
+struct edge_list_labels {
+  static_assert(std::is_arithmetic<T>::value,
+    "the labels are not numbers, pass a label parser");
+
+  bool parse(const char* first, const char* last, T &label) const{
+    return edge_list_number(first, last, label);
+  }
+
+  void format(export_buffer &out, const T &label) const{
+    out.number(label);
+  }
+
+  void text(export_buffer &out, const T &label) const{
+    out.number(label);
+  }
+};
+
+/**
+ * @brief label parser for std::string labels, the label is the whole field
+ *
+ * The characters that would split or hide the field are escaped with
+ * a backslash: \\ for the backslash, \s for the space, \t, \r and \n,
+ * and \# for a # at the start of the label. The empty label is \e.
+ */
+struct edge_list_string_labels {
+  bool parse(const char* first, const char* last, std::string &label) const{
+    label.clear();
+    if(last - first == 2 && first[0] == '\\' && first[1] == 'e')
+      return true;
+    for(; first != last; first++){
+      if(*first != '\\'){
+        label.push_back(*first);
+        continue;
+      }
+      if(++first == last)
+        return false;
+      switch(*first){
+        case '\\': label.push_back('\\'); break;
+        case 's': label.push_back(' '); break;
+        case 't': label.push_back('\t'); break;
+        case 'r': label.push_back('\r'); break;
+        case 'n': label.push_back('\n'); break;
+        case '#': label.push_back('#'); break;
+        default: return false;
+      }
+    }
+    return true;
+  }
+
+  void format(export_buffer &out, const std::string &label) const{
+    if(label.empty()){
+      out.put("\\e", 2);
+      return;
+    }
+    for(std::size_t c=0; c<label.size(); c++){
+      switch(label[c]){
+        case '\\': out.put("\\\\", 2); break;
+        case ' ': out.put("\\s", 2); break;
+        case '\t': out.put("\\t", 2); break;
+        case '\r': out.put("\\r", 2); break;
+        case '\n': out.put("\\n", 2); break;
+        case '#':
+          if(c == 0)
+            out.put('\\');
+          out.put('#');
+          break;
+        default: out.put(label[c]);
+      }
+    }
+  }
+
+  void text(export_buffer &out, const std::string &label) const{
+    out.put(label.data(), label.size());
+  }
+};
+
+/**
+ * @brief reads a stream in blocks of whole lines
+ *
+ * A block holds the lines that end in the next chunk of the stream,
+ * the partial line at the end of the chunk is moved to the next block.
+ * A block is longer than the chunk only to hold a line longer than it.
+ */
+class edge_list_reader {
+  private:
+    std::istream &_in;
+    std::size_t _chunk;
+    std::vector<char> _carry;
+    bool _end;
+
+  public:
+    /**
+     * @param in the stream
+     * @param chunk the amount of bytes read at a time
+     */
+    edge_list_reader(std::istream &in, std::size_t chunk) :
+      _in(in), _chunk(chunk > 0 ? chunk : 1), _end(false) {}
+
+    /**
+     * @brief read the next block
+     *
+     * @param block filled with whole lines, the last one may lack the \n
+     *   at the end of the stream
+     * @return false when the stream has no more lines
+     * @throw std::bad_alloc
+     */
+    bool next(std::vector<char> &block){
+      block.swap(_carry);
+      _carry.clear();
+      while(!_end){
+        const std::size_t old = block.size();
+        block.resize(old + _chunk);
+        _in.read(block.data() + old, _chunk);
+        const std::size_t read = static_cast<std::size_t>(_in.gcount());
+        block.resize(old + read);
+        if(read < _chunk)
+          _end = true;
+        for(std::size_t c=block.size(); c>old; c--)
+          if(block[c-1] == '\n'){
+            _carry.assign(block.begin() + c, block.end());
+            block.resize(c);
+            return true;
+          }
+      }
+      return !block.empty();
+    }
+};
+
+/**
+ * @brief parse the lines of a block
+ *
+ * @param first the first character of the block
+ * @param last the end of the block
+ * @param parser the label parser
+ * @param weighted true to parse the weights, false to ignore them
+ * @param unit the weight of the edges without one
+ * @param labels the labels of the start and end node of every edge are appended
+ * @param weights the weights of the edges are appended, when weighted
+ * @return false when a line is not valid
+ * @throw std::bad_alloc
+ */
+template <typename T, typename W, typename P>
+bool edge_list_parse(const char* first, const char* last, const P &parser, bool weighted, const W &unit,
+    std::vector<T> &labels, std::vector<W> &weights){
+  auto blank = [](char c){ return c == ' ' || c == '\t' || c == '\r'; };
+  while(first != last){
+    const char* end = first;
+    while(end != last && *end != '\n')
+      end++;
+    const char* next = end == last ? last : end + 1;
+
+    //split the line in at most three fields
+    const char* field[3];
+    const char* field_end[3];
+    int fields = 0;
+    const char* c = first;
+    while(true){
+      while(c != end && blank(*c))
+        c++;
+      if(c == end || (fields == 0 && *c == '#'))
+        break;
+      if(fields == 3)
+        return false;
+      field[fields] = c;
+      while(c != end && !blank(*c))
+        c++;
+      field_end[fields++] = c;
+    }
+
+    if(fields == 1)
+      return false;
+    if(fields >= 2){
+      labels.emplace_back();
+      labels.emplace_back();
+      if(!parser.parse(field[0], field_end[0], labels[labels.size()-2]) ||
+          !parser.parse(field[1], field_end[1], labels[labels.size()-1]))
+        return false;
+      if(weighted){
+        weights.push_back(unit);
+        if(fields == 3){
+          if constexpr (std::is_arithmetic<W>::value){
+            if(!edge_list_number(field[2], field_end[2], weights.back()))
+              return false;
+          }
+          else
+            return false;
+        }
+      }
+    }
+    first = next;
+  }
+  return true;
+}
+
+/**
+ * @brief assigns consecutive positions to the labels, in order of appearance
+ *
+ * An open addressing hash table of the positions, with linear probing.
+ * Small trivially copyable labels are also kept in the table, so that
+ * a lookup reads a single slot.
+ */
+template <typename T, typename Hash, typename Equal>
+class edge_list_interner {
+  private:
+    static constexpr bool _inline = std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(unsigned long long);
+
+    struct _slot_type {
+      unsigned int position;
+      typename std::conditional<_inline, T, char>::type label;
+    };
+
+    std::vector<T> _labels;
+    std::vector<_slot_type> _slots;
+    Hash _hash;
+    Equal _eql;
+
+    /**
+     * @brief marks the empty slots
+     *
+     */
+    static constexpr unsigned int _empty = static_cast<unsigned int>(-1);
+
+    std::size_t _home(const T &label) const{
+      unsigned long long h = static_cast<unsigned long long>(_hash(label));
+      h *= 0x9E3779B97F4A7C15ull;
+      return static_cast<std::size_t>(h >> 32) & (_slots.size()-1);
+    }
+
+    bool _holds(const _slot_type &slot, const T &label) const{
+      if constexpr (_inline)
+        return _eql(slot.label, label);
+      else
+        return _eql(_labels[slot.position], label);
+    }
+
+    /**
+     * @brief double the table, that is kept at most half full
+     */
+    void _grow(){
+      std::vector<_slot_type> slots(_slots.empty() ? 1024 : _slots.size()*2);
+      for(std::size_t s=0; s<slots.size(); s++)
+        slots[s].position = _empty;
+      _slots.swap(slots);
+      const std::size_t mask = _slots.size()-1;
+      for(std::size_t i=0; i<_labels.size(); i++){
+        std::size_t s = _home(_labels[i]);
+        while(_slots[s].position != _empty)
+          s = (s+1) & mask;
+        _slots[s].position = static_cast<unsigned int>(i);
+        if constexpr (_inline)
+          _slots[s].label = _labels[i];
+      }
+    }
+
+  public:
+    /**
+     * @brief the position of a label, the label is added when new
+     *
+     * @throw std::bad_alloc
+     */
+    unsigned int intern(T &&label){
+      if((_labels.size()+1)*2 > _slots.size())
+        _grow();
+      const std::size_t mask = _slots.size()-1;
+      std::size_t s = _home(label);
+      for(; _slots[s].position != _empty; s = (s+1) & mask)
+        if(_holds(_slots[s], label))
+          return _slots[s].position;
+      _slots[s].position = static_cast<unsigned int>(_labels.size());
+      if constexpr (_inline)
+        _slots[s].label = label;
+      _labels.push_back(std::move(label));
+      return _slots[s].position;
+    }
+
+    /**
+     * @brief the interned labels, by position
+     *
+     */
+    std::vector<T>& labels(){
+      return _labels;
+    }
+};
+
+#endif
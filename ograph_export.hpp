@@ -0,0 +1,170 @@
+/**
+ * @file ograph_export.hpp
+ * @brief buffered text output of the oriented graph exports
+ *
+ * The exports format the numbers with std::to_chars into a large buffer,
+ * and hand the buffer to the stream or to the file descriptor only when
+ * it is full, so the cost of the output is one call per buffer, not one
+ * per number.
+ */
+
+#ifndef OGRAPH_EXPORT_HPP
+#define OGRAPH_EXPORT_HPP
+
+#include <charconv>  // std::to_chars
+#include <cstddef>   // std::size_t
+#include <cstring>   // std::memcpy
+#include <ostream>   // std::ostream
+#include <vector>    // std::vector
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OGRAPH_FD 1
+#include <cerrno>     // errno
+#include <unistd.h>   // write
+#else
+#define OGRAPH_FD 0
+#endif
+
+/**
+ * @brief default size of the export buffer
+ *
+ */
+constexpr std::size_t export_buffer_size = 1 << 20;
+
+/**
+ * @brief an output buffer, on a stream or on a file descriptor
+ *
+ * The owner must call flush at the end of the output, the destructor
+ * drops what was not flushed.
+ */
+class export_buffer {
+  private:
+    std::ostream* _out;
+    int _fd;
+    std::vector<char> _data;
+    std::size_t _used;
+    bool _escape;
+    bool _failed;
+
+    /**
+     * @brief the largest text of a number, for every arithmetic type
+     *
+     */
+    static constexpr std::size_t _number_room = 64;
+
+  public:
+    /**
+     * @param out the stream
+     * @param size the size of the buffer
+     * @throw std::bad_alloc
+     */
+    explicit export_buffer(std::ostream &out, std::size_t size = export_buffer_size) :
+      _out(&out), _fd(-1), _data(size > _number_room ? size : _number_room), _used(0), _escape(false), _failed(false) {}
+
+    /**
+     * @param fd the file descriptor, left open
+     * @param size the size of the buffer
+     * @throw std::bad_alloc
+     */
+    explicit export_buffer(int fd, std::size_t size = export_buffer_size) :
+      _out(nullptr), _fd(fd), _data(size > _number_room ? size : _number_room), _used(0), _escape(false), _failed(false) {}
+
+    export_buffer(const export_buffer &other) = delete;
+    export_buffer& operator=(const export_buffer &other) = delete;
+
+    /**
+     * @brief escape the quotes and the backslashes, for the quoted strings of DOT
+     *
+     */
+    void escape(bool escape){
+      _escape = escape;
+    }
+
+    /**
+     * @brief make room for n characters
+     *
+     * @pre n <= the size of the buffer
+     * @return the first free character
+     */
+    char* room(std::size_t n){
+      if(_data.size() - _used < n)
+        flush();
+      return _data.data() + _used;
+    }
+
+    /**
+     * @brief mark n characters written at room() as used
+     *
+     */
+    void commit(std::size_t n){
+      _used += n;
+    }
+
+    void put(char c){
+      if(_escape && (c == '"' || c == '\\')){
+        room(2)[0] = '\\';
+        commit(1);
+      }
+      *room(1) = c;
+      commit(1);
+    }
+
+    void put(const char* text, std::size_t n){
+      if(_escape){
+        for(std::size_t c=0; c<n; c++)
+          put(text[c]);
+        return;
+      }
+      while(n > 0){
+        const std::size_t chunk = n < _data.size() ? n : _data.size();
+        std::memcpy(room(chunk), text, chunk);
+        commit(chunk);
+        text += chunk;
+        n -= chunk;
+      }
+    }
+
+    void put(const char* text){
+      put(text, std::strlen(text));
+    }
+
+    /**
+     * @brief write a number, in the shortest form that reads back the same value
+     *
+     */
+    template <typename N>
+    void number(N value){
+      char* first = room(_number_room);
+      commit(static_cast<std::size_t>(std::to_chars(first, first + _number_room, value).ptr - first));
+    }
+
+    /**
+     * @brief hand the buffered characters to the stream or to the file descriptor
+     *
+     * @return false when the output failed, now or at a previous flush
+     */
+    bool flush(){
+      if(_out != nullptr){
+        _out->write(_data.data(), _used);
+        _failed = _failed || !*_out;
+      }
+      else{
+        #if OGRAPH_FD
+        std::size_t done = 0;
+        while(done < _used && !_failed){
+          const ssize_t written = ::write(_fd, _data.data() + done, _used - done);
+          if(written > 0)
+            done += static_cast<std::size_t>(written);
+          else if(written == 0 || errno != EINTR)
+            _failed = true;
+        }
+        #else
+        _failed = true;
+        #endif
+      }
+      _used = 0;
+      return !_failed;
+    }
+};
+
+#endif
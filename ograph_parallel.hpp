@@ -0,0 +1,170 @@
+/**
+ * @file ograph_parallel.hpp
+ * @brief a small team of threads for the parallel algorithms of the oriented graph
+ *
+ * The algorithms work in synchronous steps: every step runs the same
+ * function on all the threads of the team, and waits for all of them.
+ * The threads are created once per algorithm, not once per step.
+ */
+
+#ifndef OGRAPH_PARALLEL_HPP
+#define OGRAPH_PARALLEL_HPP
+
+#include <condition_variable> // std::condition_variable
+#include <cstddef>   // std::size_t
+#include <exception> // std::exception_ptr
+#include <functional> // std::function
+#include <mutex>     // std::mutex
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+
+/**
+ * @brief the amount of threads to use for a parallel algorithm
+ *
+ * @param requested the amount asked by the user, 0 to use all the cores
+ * @return requested, or the amount of cores when requested is 0
+ */
+inline unsigned parallel_threads(unsigned requested){
+  if(requested > 0)
+    return requested;
+  const unsigned cores = std::thread::hardware_concurrency();
+  return cores > 0 ? cores : 1;
+}
+
+/**
+ * @brief a fixed set of threads that run the same function in steps
+ *
+ * The thread that creates the team takes part in every step as thread 0,
+ * so a team of one thread never starts a new thread.
+ */
+class parallel_team {
+  public:
+
+    /**
+     * @brief constructor, starts the threads
+     *
+     * @param threads the amount of threads in the team, at least 1
+     * @throw std::system_error a thread could not be started
+     * @throw std::bad_alloc
+     */
+    explicit parallel_team(unsigned threads) :
+      _size(threads > 0 ? threads : 1), _generation(0), _pending(0), _stop(false) {
+      try{
+        for(unsigned t=1; t<_size; t++)
+          _workers.push_back(std::thread(&parallel_team::_work, this, t));
+      }
+      catch(...){
+        _join();
+        throw;
+      }
+    }
+
+    /**
+     * @brief destructor, stops and joins the threads
+     */
+    ~parallel_team(){
+      _join();
+    }
+
+    parallel_team(const parallel_team &other) = delete;
+    parallel_team& operator=(const parallel_team &other) = delete;
+
+    /**
+     * @brief the amount of threads in the team
+     */
+    unsigned size() const{
+      return _size;
+    }
+
+    /**
+     * @brief run a step: call f(thread) on every thread, and wait for all of them
+     *
+     * The writes made by a step are visible to the following steps,
+     * and to the caller after run returns.
+     *
+     * @param f the function, called with the index of the thread in [0, size())
+     * @throw the first exception thrown by f, after all the threads are done
+     */
+    void run(const std::function<void(unsigned)> &f){
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _task = &f;
+        _error = nullptr;
+        _pending = _size - 1;
+        _generation++;
+      }
+      _start.notify_all();
+      _call(0);
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this]{ return _pending == 0; });
+      _task = nullptr;
+      if(_error)
+        std::rethrow_exception(_error);
+    }
+
+  private:
+    unsigned _size;
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    const std::function<void(unsigned)>* _task = nullptr;
+    std::size_t _generation;
+    unsigned _pending;
+    bool _stop;
+    std::exception_ptr _error;
+
+    /**
+     * @brief run the current task on a thread, keeping the first exception
+     */
+    void _call(unsigned t){
+      try{
+        (*_task)(t);
+      }
+      catch(...){
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_error)
+          _error = std::current_exception();
+      }
+    }
+
+    /**
+     * @brief the loop of a worker thread
+     */
+    void _work(unsigned t){
+      std::size_t seen = 0;
+      for(;;){
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _start.wait(lock, [&]{ return _stop || _generation != seen; });
+          if(_stop)
+            return;
+          seen = _generation;
+        }
+        _call(t);
+        bool last;
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          last = (--_pending == 0);
+        }
+        if(last)
+          _done.notify_one();
+      }
+    }
+
+    /**
+     * @brief stop and join the started threads
+     */
+    void _join(){
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _start.notify_all();
+      for(std::size_t t=0; t<_workers.size(); t++)
+        _workers[t].join();
+      _workers.clear();
+    }
+};
+
+#endif
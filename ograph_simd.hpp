@@ -0,0 +1,327 @@
+/**
+ * @file ograph_simd.hpp
+ * @brief vectorized kernels for the whole-matrix scans of the storage policies
+ *
+ * Every kernel has a portable scalar version. On x86 the AVX2, SSE2 and
+ * POPCNT versions are compiled with per-function target attributes, so the
+ * rest of the program does not need any special compiler flag, and the
+ * best version supported by the running cpu is selected once, at the first
+ * call of simd_dispatch().
+ *
+ * The kernels are:
+ *  - sum(cells, n), the sum of n integers
+ *  - accumulate(acc, cells, n), acc[j] += cells[j] for n integers
+ *  - popcount(words, n), the amount of set bits in n 64 bit words
+ *  - unite(dst, src, n), dst[w] |= src[w] for n 64 bit words
+ *  - relax(dst, src, add, n), dst[j] = min(dst[j], src[j] + add) for n integers,
+ *    the min-plus step of the shortest paths. The sums must not overflow
+ *  - relax_wide(dst, src, add, n), the same for n 64 bit integers
+ */
+
+#ifndef OGRAPH_SIMD_HPP
+#define OGRAPH_SIMD_HPP
+
+#include <algorithm> // std::min
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OGRAPH_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define OGRAPH_SIMD_X86 0
+#endif
+
+/**
+ * @brief a set of kernels, all built for the same instruction set
+ *
+ */
+struct simd_kernels {
+  std::size_t (*sum)(const int* cells, std::size_t n);
+  void (*accumulate)(unsigned int* acc, const int* cells, std::size_t n);
+  std::size_t (*popcount)(const std::uint64_t* words, std::size_t n);
+  void (*unite)(std::uint64_t* dst, const std::uint64_t* src, std::size_t n);
+  void (*relax)(int* dst, const int* src, int add, std::size_t n);
+  void (*relax_wide)(long long* dst, const long long* src, long long add, std::size_t n);
+
+  /**
+   * @brief the instruction set of the kernels, for diagnostics
+   *
+   */
+  const char* name;
+};
+
+//------ portable kernels ----------
+
+inline std::size_t simd_sum_scalar(const int* cells, std::size_t n){
+  std::size_t sum = 0;
+  for(std::size_t c=0; c<n; c++)
+    sum += cells[c];
+  return sum;
+}
+
+inline void simd_accumulate_scalar(unsigned int* acc, const int* cells, std::size_t n){
+  for(std::size_t c=0; c<n; c++)
+    acc[c] += cells[c];
+}
+
+inline std::size_t simd_popcount_scalar(const std::uint64_t* words, std::size_t n){
+  std::size_t count = 0;
+  for(std::size_t w=0; w<n; w++)
+    count += __builtin_popcountll(words[w]);
+  return count;
+}
+
+inline void simd_unite_scalar(std::uint64_t* dst, const std::uint64_t* src, std::size_t n){
+  for(std::size_t w=0; w<n; w++)
+    dst[w] |= src[w];
+}
+
+inline void simd_relax_scalar(int* dst, const int* src, int add, std::size_t n){
+  for(std::size_t j=0; j<n; j++)
+    dst[j] = std::min(dst[j], src[j] + add);
+}
+
+inline void simd_relax_wide_scalar(long long* dst, const long long* src, long long add, std::size_t n){
+  for(std::size_t j=0; j<n; j++)
+    dst[j] = std::min(dst[j], src[j] + add);
+}
+
+#if OGRAPH_SIMD_X86
+
+/**
+ * @brief amount of vectors summed in 32 bit lanes before widening the sum
+ *
+ * Keeps the lanes from overflowing for any value of the cells
+ * that fits in a 16 bit integer, like the 0 and 1 of the matrix.
+ */
+constexpr std::size_t simd_sum_block = 1 << 15;
+
+//------ SSE2 kernels ----------
+
+__attribute__((target("sse2")))
+inline std::size_t simd_sum_sse2(const int* cells, std::size_t n){
+  std::size_t sum = 0;
+  std::size_t c = 0;
+  while(n - c >= 4){
+    const std::size_t end = c + std::min((n - c) / 4, simd_sum_block) * 4;
+    __m128i acc = _mm_setzero_si128();
+    for(; c<end; c+=4)
+      acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells+c)));
+    alignas(16) int lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    sum += static_cast<std::size_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+  }
+  return sum + simd_sum_scalar(cells+c, n-c);
+}
+
+__attribute__((target("sse2")))
+inline void simd_accumulate_sse2(unsigned int* acc, const int* cells, std::size_t n){
+  std::size_t c = 0;
+  for(; c+4<=n; c+=4){
+    __m128i* dst = reinterpret_cast<__m128i*>(acc+c);
+    const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells+c));
+    _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), src));
+  }
+  simd_accumulate_scalar(acc+c, cells+c, n-c);
+}
+
+__attribute__((target("sse2")))
+inline void simd_unite_sse2(std::uint64_t* dst, const std::uint64_t* src, std::size_t n){
+  std::size_t w = 0;
+  for(; w+2<=n; w+=2){
+    __m128i* d = reinterpret_cast<__m128i*>(dst+w);
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+w));
+    _mm_storeu_si128(d, _mm_or_si128(_mm_loadu_si128(d), s));
+  }
+  simd_unite_scalar(dst+w, src+w, n-w);
+}
+
+/**
+ * @brief SSE2 has no 32 bit min, the smaller lanes are selected with a mask
+ */
+__attribute__((target("sse2")))
+inline void simd_relax_sse2(int* dst, const int* src, int add, std::size_t n){
+  const __m128i a = _mm_set1_epi32(add);
+  std::size_t j = 0;
+  for(; j+4<=n; j+=4){
+    __m128i* d = reinterpret_cast<__m128i*>(dst+j);
+    const __m128i old = _mm_loadu_si128(d);
+    const __m128i sum = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+j)), a);
+    const __m128i smaller = _mm_cmplt_epi32(sum, old);
+    _mm_storeu_si128(d, _mm_or_si128(_mm_and_si128(smaller, sum), _mm_andnot_si128(smaller, old)));
+  }
+  simd_relax_scalar(dst+j, src+j, add, n-j);
+}
+
+//------ POPCNT kernels ----------
+
+__attribute__((target("popcnt")))
+inline std::size_t simd_popcount_popcnt(const std::uint64_t* words, std::size_t n){
+  //four independent sums, so the popcnt instructions can overlap
+  std::size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+  std::size_t w = 0;
+  for(; w+4<=n; w+=4){
+    c0 += __builtin_popcountll(words[w]);
+    c1 += __builtin_popcountll(words[w+1]);
+    c2 += __builtin_popcountll(words[w+2]);
+    c3 += __builtin_popcountll(words[w+3]);
+  }
+  for(; w<n; w++)
+    c0 += __builtin_popcountll(words[w]);
+  return c0 + c1 + c2 + c3;
+}
+
+//------ AVX2 kernels ----------
+
+__attribute__((target("avx2")))
+inline std::size_t simd_sum_avx2(const int* cells, std::size_t n){
+  std::size_t sum = 0;
+  std::size_t c = 0;
+  while(n - c >= 8){
+    const std::size_t end = c + std::min((n - c) / 8, simd_sum_block) * 8;
+    __m256i acc = _mm256_setzero_si256();
+    for(; c<end; c+=8)
+      acc = _mm256_add_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells+c)));
+    alignas(32) int lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    for(int l=0; l<8; l++)
+      sum += lanes[l];
+  }
+  return sum + simd_sum_scalar(cells+c, n-c);
+}
+
+__attribute__((target("avx2")))
+inline void simd_accumulate_avx2(unsigned int* acc, const int* cells, std::size_t n){
+  std::size_t c = 0;
+  for(; c+8<=n; c+=8){
+    __m256i* dst = reinterpret_cast<__m256i*>(acc+c);
+    const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells+c));
+    _mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst), src));
+  }
+  simd_accumulate_scalar(acc+c, cells+c, n-c);
+}
+
+__attribute__((target("avx2")))
+inline void simd_unite_avx2(std::uint64_t* dst, const std::uint64_t* src, std::size_t n){
+  std::size_t w = 0;
+  for(; w+4<=n; w+=4){
+    __m256i* d = reinterpret_cast<__m256i*>(dst+w);
+    const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+w));
+    _mm256_storeu_si256(d, _mm256_or_si256(_mm256_loadu_si256(d), s));
+  }
+  simd_unite_scalar(dst+w, src+w, n-w);
+}
+
+__attribute__((target("avx2")))
+inline void simd_relax_avx2(int* dst, const int* src, int add, std::size_t n){
+  const __m256i a = _mm256_set1_epi32(add);
+  std::size_t j = 0;
+  for(; j+8<=n; j+=8){
+    __m256i* d = reinterpret_cast<__m256i*>(dst+j);
+    const __m256i sum = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+j)), a);
+    _mm256_storeu_si256(d, _mm256_min_epi32(_mm256_loadu_si256(d), sum));
+  }
+  simd_relax_scalar(dst+j, src+j, add, n-j);
+}
+
+/**
+ * @brief AVX2 has no 64 bit min, the smaller lanes are selected with a compare and a blend
+ *
+ * SSE2 has no 64 bit compare, so it uses the scalar version.
+ */
+__attribute__((target("avx2")))
+inline void simd_relax_wide_avx2(long long* dst, const long long* src, long long add, std::size_t n){
+  const __m256i a = _mm256_set1_epi64x(add);
+  std::size_t j = 0;
+  for(; j+4<=n; j+=4){
+    __m256i* d = reinterpret_cast<__m256i*>(dst+j);
+    const __m256i old = _mm256_loadu_si256(d);
+    const __m256i sum = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+j)), a);
+    _mm256_storeu_si256(d, _mm256_blendv_epi8(old, sum, _mm256_cmpgt_epi64(old, sum)));
+  }
+  simd_relax_wide_scalar(dst+j, src+j, add, n-j);
+}
+
+/**
+ * @brief count the bits with a lookup of the nibbles in a shuffle
+ *
+ * The byte counts are added horizontally with a sum of absolute differences,
+ * four 64 bit lanes at a time.
+ */
+__attribute__((target("avx2,popcnt")))
+inline std::size_t simd_popcount_avx2(const std::uint64_t* words, std::size_t n){
+  const __m256i lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t w = 0;
+  for(; w+4<=n; w+=4){
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words+w));
+    const __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+    const __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+  }
+  alignas(32) std::uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  std::size_t count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for(; w<n; w++)
+    count += __builtin_popcountll(words[w]);
+  return count;
+}
+
+#endif
+
+/**
+ * @brief the portable kernels
+ *
+ */
+inline const simd_kernels& simd_scalar(){
+  static const simd_kernels kernels = {
+    simd_sum_scalar, simd_accumulate_scalar, simd_popcount_scalar, simd_unite_scalar, simd_relax_scalar,
+    simd_relax_wide_scalar, "scalar"
+  };
+  return kernels;
+}
+
+/**
+ * @brief select the best kernels supported by the running cpu
+ *
+ */
+inline simd_kernels simd_select(){
+  simd_kernels kernels = simd_scalar();
+  #if OGRAPH_SIMD_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("sse2")){
+    kernels.sum = simd_sum_sse2;
+    kernels.accumulate = simd_accumulate_sse2;
+    kernels.unite = simd_unite_sse2;
+    kernels.relax = simd_relax_sse2;
+    kernels.name = "sse2";
+  }
+  if(__builtin_cpu_supports("popcnt"))
+    kernels.popcount = simd_popcount_popcnt;
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")){
+    kernels.sum = simd_sum_avx2;
+    kernels.accumulate = simd_accumulate_avx2;
+    kernels.popcount = simd_popcount_avx2;
+    kernels.unite = simd_unite_avx2;
+    kernels.relax = simd_relax_avx2;
+    kernels.relax_wide = simd_relax_wide_avx2;
+    kernels.name = "avx2";
+  }
+  #endif
+  return kernels;
+}
+
+/**
+ * @brief the kernels used by the storage policies
+ *
+ */
+inline const simd_kernels& simd_dispatch(){
+  static const simd_kernels kernels = simd_select();
+  return kernels;
+}
+
+#endif
@@ -0,0 +1,205 @@
+/**
+ * @file ograph_snapshot.hpp
+ * @brief binary snapshot format of the oriented graph
+ *
+ * A snapshot file has four sections:
+ *  - the header, a snapshot_header
+ *  - the node labels, in position order, written by a label serializer
+ *  - the out degrees then the in degrees of the nodes, 32 bit each
+ *  - the adjacency image of the storage policy, starting at a multiple
+ *    of snapshot_alignment, so it can be memory mapped
+ *
+ * The numbers are written in the byte order of the machine, the header
+ * records it. The files are meant to be reloaded on the same platform.
+ */
+
+#ifndef OGRAPH_SNAPSHOT_HPP
+#define OGRAPH_SNAPSHOT_HPP
+
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint32_t
+#include <cstring>   // std::memcmp
+#include <istream>   // std::istream
+#include <ostream>   // std::ostream
+#include <string>    // std::string
+#include <type_traits> // std::is_trivially_copyable
+
+/**
+ * @brief version of the snapshot format written by this library
+ *
+ */
+constexpr std::uint32_t snapshot_version = 2;
+
+/**
+ * @brief alignment of the adjacency section in the file
+ *
+ * A multiple of the page size of the common platforms,
+ * the section can be mapped with its own offset.
+ */
+constexpr std::uint64_t snapshot_alignment = 65536;
+
+/**
+ * @brief the first bytes of a snapshot file
+ *
+ */
+constexpr char snapshot_magic[8] = {'O', 'G', 'R', 'A', 'P', 'H', '\r', '\n'};
+
+/**
+ * @brief flag of the graphs saved in acyclic mode
+ *
+ */
+constexpr std::uint32_t snapshot_acyclic = 1;
+
+/**
+ * @brief the kind of a type in the type tags, see snapshot_type_tag
+ *
+ */
+enum snapshot_type_kind : std::uint32_t {
+  snapshot_unsigned = 1,
+  snapshot_signed = 2,
+  snapshot_floating = 3,
+  snapshot_bytes = 4,
+  snapshot_text = 5
+};
+
+/**
+ * @brief the tag of a type in the header, its kind and its size
+ *
+ * Tells apart the types of the same size, like int and float,
+ * that the sizes alone would let load in place of each other.
+ */
+template <typename X>
+constexpr std::uint32_t snapshot_type_tag(){
+  const std::uint32_t kind = std::is_floating_point<X>::value ? snapshot_floating :
+    std::is_integral<X>::value ? (std::is_signed<X>::value ? snapshot_signed : snapshot_unsigned) : snapshot_bytes;
+  return kind << 24 | static_cast<std::uint32_t>(sizeof(X));
+}
+
+/**
+ * @brief the header of a snapshot file
+ *
+ */
+struct snapshot_header {
+  char magic[8];
+  std::uint32_t version;
+
+  /**
+   * @brief 0x01020304, as written by the machine that saved the file
+   *
+   */
+  std::uint32_t byte_order;
+
+  /**
+   * @brief the snapshot_kind of the storage policy
+   *
+   */
+  std::uint32_t storage;
+
+  /**
+   * @brief the size of the edge weights, 0 without weights
+   *
+   */
+  std::uint32_t weight_size;
+
+  /**
+   * @brief the size of every label, 0 for the labels of variable size
+   *
+   */
+  std::uint32_t label_size;
+
+  std::uint32_t nodes;
+
+  /**
+   * @brief snapshot_acyclic when the graph was in acyclic mode
+   *
+   */
+  std::uint32_t flags;
+
+  /**
+   * @brief the snapshot_type_tag of the edge weights, 0 without weights
+   *
+   */
+  std::uint32_t weight_type;
+
+  /**
+   * @brief the label_type of the label serializer
+   *
+   */
+  std::uint32_t label_type;
+
+  /**
+   * @brief always 0, keeps the 64 bit fields aligned without padding bytes
+   *
+   */
+  std::uint32_t reserved;
+
+  std::uint64_t edges;
+  std::uint64_t degrees_offset;
+  std::uint64_t adjacency_offset;
+  std::uint64_t adjacency_size;
+};
+
+/**
+ * @brief default label serializer, for trivially copyable labels
+ *
+ * A label serializer provides:
+ *  - label_size, the size of every label in the file, or 0
+ *  - label_type, the tag of the labels in the file, like snapshot_type_tag
+ *  - write(out, label), to append a label to the stream
+ *  - read(in, label, limit), to read a label written by write, that sets
+ *    the failbit of the stream when the label takes more than limit bytes
+ *
+ * This one copies the bytes of the labels.
+ */
+template <typename T>
+struct snapshot_labels {
+  static_assert(std::is_trivially_copyable<T>::value,
+    "the labels are not trivially copyable, pass a label serializer");
+
+  static constexpr std::uint32_t label_size = sizeof(T);
+  static constexpr std::uint32_t label_type = snapshot_type_tag<T>();
+
+  void write(std::ostream &out, const T &label) const{
+    out.write(reinterpret_cast<const char*>(&label), sizeof(T));
+  }
+
+  void read(std::istream &in, T &label, std::uint64_t limit) const{
+    if(limit < sizeof(T)){
+      in.setstate(std::ios::failbit);
+      return;
+    }
+    in.read(reinterpret_cast<char*>(&label), sizeof(T));
+  }
+};
+
+/**
+ * @brief label serializer for std::string labels
+ *
+ * Every label is its length, 32 bit, followed by its characters.
+ */
+struct snapshot_string_labels {
+  static constexpr std::uint32_t label_size = 0;
+  static constexpr std::uint32_t label_type = snapshot_text << 24;
+
+  void write(std::ostream &out, const std::string &label) const{
+    const std::uint32_t length = static_cast<std::uint32_t>(label.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(label.data(), length);
+  }
+
+  void read(std::istream &in, std::string &label, std::uint64_t limit) const{
+    std::uint32_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if(!in)
+      return;
+    //the length is checked before it is allocated
+    if(sizeof(length) + std::uint64_t(length) > limit){
+      in.setstate(std::ios::failbit);
+      return;
+    }
+    label.resize(length);
+    in.read(&label[0], length);
+  }
+};
+
+#endif
@@ -0,0 +1,2000 @@
+/**
+ * @file ograph_storage.hpp
+ * @brief storage policies for the adjacency data of the oriented graph
+ *
+ * A storage policy holds the edges between the nodes of an oriented_graph,
+ * addressed by the position of the nodes in the graph.
+ * The graph owns the node labels, the storage only knows about positions.
+ *
+ * Every storage policy provides:
+ *  - a constructor taking the capacity, that allocates an empty storage
+ *  - copy_from(other, size), to copy the edges of the first size nodes
+ *  - move_from(other, size), same as copy_from, but can steal the data of other
+ *  - swap(other)
+ *  - test(i, j), set(i, j, w), reset(i, j) on a single edge
+ *  - weight(i, j), the weight of an existing edge
+ *  - remove(k, size), to remove the node at position k, moving the last
+ *    node to position k
+ *  - compact(remap, size), to remove many nodes in a single pass
+ *  - count(size), the amount of edges between the first size nodes
+ *  - degrees(size, out, in), the out and in degree of the first size nodes
+ *  - next_out(i, j, size), the first successor of i from position j
+ *  - next_in(j, i, size), the first predecessor of j from position i
+ *  - each_out(i, size, f), calls f(j, weight) for every successor j of i, in order
+ *  - freeze(size), to compact the edges in a read-optimized form
+ *  - assign(size, from, to, weights, count), to fill an empty storage with many edges
+ *  - image_size(size), write_image(out, size) and read_image(in, size, edges),
+ *    the adjacency section of a snapshot file, see ograph_snapshot.hpp
+ *  - valid_image(size), false when a read or mapped image holds cells that
+ *    write_image never writes
+ *  - snapshot_kind, the tag of the storage in the snapshot files, and mappable,
+ *    true when the storage also provides adopt(mapping, size), to use a memory
+ *    mapped image of the file in place
+ *
+ * The weight of the edges has type weight_type: no_weight for the
+ * storages that only record the presence of the edges.
+ *
+ * Only the constructor, copy_from, set, freeze and assign can throw, and
+ * all but assign provide the strong exception guarantee. Positions outside the first size nodes
+ * never hold edges.
+ */
+
+#ifndef OGRAPH_STORAGE_HPP
+#define OGRAPH_STORAGE_HPP
+
+#include <algorithm> // std::swap, std::copy, std::fill
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <istream>   // std::istream
+#include <new>       // std::align_val_t
+#include <ostream>   // std::ostream
+#include <type_traits> // std::is_same
+#include <vector>    // std::vector
+#include "ograph_simd.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OGRAPH_MMAP 1
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap
+#include <unistd.h>   // close
+#else
+#define OGRAPH_MMAP 0
+#endif
+
+/**
+ * @brief alignment of the storage rows, in bytes
+ *
+ */
+constexpr std::size_t storage_cache_line = 64;
+
+/**
+ * @brief marker for a removed node in the remap array given to compact()
+ *
+ */
+constexpr unsigned int storage_removed = static_cast<unsigned int>(-1);
+
+/**
+ * @brief weight type of the storages without weights
+ *
+ */
+struct no_weight {};
+
+/**
+ * @brief allocate a zeroed, cache line aligned array
+ *
+ * @tparam C the cell type, a trivial type
+ * @param cells the amount of cells
+ * @throw std::bad_alloc
+ * @return the array, or nullptr when it has no cells
+ */
+template <typename C>
+C* storage_new_cells(std::size_t cells){
+  if(cells == 0)
+    return nullptr;
+  C* block = static_cast<C*>(::operator new[](cells*sizeof(C), std::align_val_t(storage_cache_line)));
+  std::fill(block, block+cells, C());
+  return block;
+}
+
+/**
+ * @brief delete an array allocated with storage_new_cells
+ *
+ * @param block the array to delete
+ */
+template <typename C>
+void storage_delete_cells(C* block){
+  if(block != nullptr)
+    ::operator delete[](block, std::align_val_t(storage_cache_line));
+}
+
+/**
+ * @brief round a length up to a whole amount of cache lines
+ *
+ * @tparam C the cell type
+ * @param cells the amount of cells in a row
+ * @return the row stride, in cells
+ */
+template <typename C>
+constexpr std::size_t storage_stride_for(std::size_t cells){
+  const std::size_t line = storage_cache_line / sizeof(C);
+  return (cells + line-1) / line * line;
+}
+
+/**
+ * @brief a private, copy-on-write memory mapping of a part of a file
+ *
+ * The storages that adopt a mapping use it in place of their own
+ * allocation. Writes to the mapped pages copy them, and never reach
+ * the file, so the storage stays mutable.
+ */
+class storage_mapping {
+  private:
+    void* _address;
+    std::size_t _length;
+
+  public:
+    storage_mapping() : _address(nullptr), _length(0) {}
+
+    ~storage_mapping(){
+      #if OGRAPH_MMAP
+      if(_address != nullptr)
+        munmap(_address, _length);
+      #endif
+    }
+
+    storage_mapping(const storage_mapping &other) = delete;
+    storage_mapping& operator=(const storage_mapping &other) = delete;
+
+    void swap(storage_mapping &other){
+      std::swap(_address, other._address);
+      std::swap(_length, other._length);
+    }
+
+    /**
+     * @brief the first mapped byte, or nullptr when nothing is mapped
+     */
+    void* data() const{
+      return _address;
+    }
+
+    /**
+     * @brief map a part of a file
+     *
+     * @param path the file
+     * @param offset the first byte to map, a multiple of the page size
+     * @param length the amount of bytes to map
+     * @return false when the file could not be mapped, the mapping is then unchanged
+     */
+    bool map(const char* path, std::size_t offset, std::size_t length){
+      #if OGRAPH_MMAP
+      if(length == 0 || offset % sysconf(_SC_PAGESIZE) != 0)
+        return false;
+      const int fd = open(path, O_RDONLY);
+      if(fd == -1)
+        return false;
+      void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+      close(fd);
+      if(address == MAP_FAILED)
+        return false;
+      storage_mapping mapped;
+      mapped._address = address;
+      mapped._length = length;
+      swap(mapped);
+      return true;
+      #else
+      (void)path;
+      (void)offset;
+      (void)length;
+      return false;
+      #endif
+    }
+};
+
+/**
+ * @brief write the first cells of the rows of a matrix, padded to the row stride of size cells
+ *
+ * This is the image of a matrix with capacity size, whatever the
+ * capacity of the written matrix.
+ *
+ * @param out the stream
+ * @param rows pointer to the first row
+ * @param stride the stride of the written matrix
+ * @param size the amount of rows
+ * @param cells the amount of cells written from every row
+ */
+template <typename C>
+void storage_write_rows(std::ostream &out, const C* rows, std::size_t stride, std::size_t size, std::size_t cells){
+  const std::size_t image_stride = storage_stride_for<C>(cells);
+  const std::vector<C> padding(image_stride - cells);
+  for(std::size_t i=0; i<size; i++){
+    out.write(reinterpret_cast<const char*>(rows + i * stride), cells * sizeof(C));
+    out.write(reinterpret_cast<const char*>(padding.data()), padding.size() * sizeof(C));
+  }
+}
+
+/**
+ * @brief a matrix of edge weights, with the same layout of the adjacency matrix
+ *
+ * Each row starts on its own cache line. The weights of the
+ * missing edges are not meaningful.
+ *
+ * @tparam W the weight type, trivially copyable
+ */
+template <typename W>
+class storage_weights {
+  static_assert(std::is_trivially_copyable<W>::value, "matrix weights must be trivially copyable");
+
+  private:
+    W* _cells;
+    std::size_t _stride;
+
+    /**
+     * @brief true when the cells belong to a mapping of the owner storage
+     *
+     */
+    bool _borrowed;
+
+  public:
+    explicit storage_weights(unsigned int capacity) :
+      _cells(nullptr), _stride(storage_stride_for<W>(capacity)), _borrowed(false) {
+      _cells = storage_new_cells<W>(capacity * _stride);
+    }
+
+    ~storage_weights(){
+      if(!_borrowed)
+        storage_delete_cells(_cells);
+    }
+
+    /**
+     * @brief use the cells of a mapped image, with capacity rows
+     *
+     * @pre the weights are empty, with capacity 0
+     */
+    void adopt(W* cells, unsigned int capacity){
+      _cells = cells;
+      _stride = storage_stride_for<W>(capacity);
+      _borrowed = true;
+    }
+
+    storage_weights(const storage_weights &other) = delete;
+    storage_weights& operator=(const storage_weights &other) = delete;
+
+    void swap(storage_weights &other){
+      std::swap(_cells, other._cells);
+      std::swap(_stride, other._stride);
+      std::swap(_borrowed, other._borrowed);
+    }
+
+    W* row(unsigned int i){
+      return _cells + i * _stride;
+    }
+
+    const W* row(unsigned int i) const{
+      return _cells + i * _stride;
+    }
+
+    std::size_t stride() const{
+      return _stride;
+    }
+};
+
+/**
+ * @brief no weights, nothing to store
+ *
+ */
+template <>
+class storage_weights<no_weight> {
+  public:
+    explicit storage_weights(unsigned int) {}
+    void swap(storage_weights &){}
+};
+
+
+/**
+ * @brief dense adjacency matrix of integers
+ *
+ * The matrix is a single row-major block of capacity rows,
+ * each row is stride cells long, and starts on its own cache line.
+ * A cell contains 1 when the edge exists, 0 otherwise.
+ * With a weight type, the weights are kept in a second matrix
+ * with the same layout.
+ *
+ * @tparam W the weight type, trivially copyable, or no_weight
+ */
+template <typename W = no_weight>
+class dense_storage {
+  public:
+    typedef unsigned int size_type;
+    typedef W weight_type;
+
+  private:
+    static constexpr bool _weighted = !std::is_same<W, no_weight>::value;
+
+    /**
+     * @brief the matrix cells
+     *
+     */
+    int* _cells;
+
+    /**
+     * @brief the amount of rows and columns in the matrix
+     *
+     */
+    size_type _capacity;
+
+    /**
+     * @brief the distance in cells between the start of two rows
+     *
+     */
+    std::size_t _stride;
+
+    /**
+     * @brief the weights of the edges
+     *
+     */
+    storage_weights<W> _weights;
+
+    /**
+     * @brief the mapped snapshot that holds the cells, see adopt()
+     *
+     */
+    storage_mapping _mapping;
+
+    /**
+     * @brief pointer to the first cell of a row
+     *
+     * @param i the row
+     */
+    int* _row(size_type i){
+      return _cells + i * _stride;
+    }
+
+    /**
+     * @brief pointer to the first cell of a row
+     *
+     * @param i the row
+     */
+    const int* _row(size_type i) const{
+      return _cells + i * _stride;
+    }
+
+  public:
+
+    /**
+     * @brief constructor
+     *
+     * @param capacity the amount of nodes the storage can hold
+     * @throw std::bad_alloc
+     */
+    explicit dense_storage(size_type capacity = 0) :
+      _cells(nullptr), _capacity(capacity), _stride(storage_stride_for<int>(capacity)), _weights(capacity) {
+      _cells = storage_new_cells<int>(_capacity * _stride);
+    }
+
+    /**
+     * @brief destructor
+     */
+    ~dense_storage(){
+      if(_mapping.data() == nullptr)
+        storage_delete_cells(_cells);
+    }
+
+    dense_storage(const dense_storage &other) = delete;
+    dense_storage& operator=(const dense_storage &other) = delete;
+
+    /**
+     * @brief swap the state of the current instance with the given instance
+     *
+     * @param other the instance to swap with
+     */
+    void swap(dense_storage &other){
+      std::swap(_cells, other._cells);
+      std::swap(_capacity, other._capacity);
+      std::swap(_stride, other._stride);
+      _weights.swap(other._weights);
+      _mapping.swap(other._mapping);
+    }
+
+    /**
+     * @brief copy the edges between the first size nodes of another storage
+     *
+     * @pre the current storage is empty, and its capacity is at least size
+     * @param other the storage to copy
+     * @param size the amount of nodes to copy
+     */
+    void copy_from(const dense_storage &other, size_type size){
+      for(size_type i=0; i<size; i++){
+        std::copy(other._row(i), other._row(i)+size, _row(i));
+        if constexpr (_weighted)
+          std::copy(other._weights.row(i), other._weights.row(i)+size, _weights.row(i));
+      }
+    }
+
+    /**
+     * @brief copy the edges between the first size nodes of another storage
+     *
+     * @pre the current storage is empty, and its capacity is at least size
+     * @param other the storage to copy
+     * @param size the amount of nodes to copy
+     */
+    void move_from(dense_storage &other, size_type size){
+      copy_from(other, size);
+    }
+
+    /**
+     * @brief capacity getter
+     */
+    size_type capacity() const{
+      return _capacity;
+    }
+
+    /**
+     * @brief check if the edge i -> j exists
+     */
+    bool test(size_type i, size_type j) const{
+      return _row(i)[j] != 0;
+    }
+
+    /**
+     * @brief the weight of the edge i -> j
+     *
+     * @pre the edge exists
+     */
+    weight_type weight(size_type i, size_type j) const{
+      if constexpr (_weighted)
+        return _weights.row(i)[j];
+      else
+        return weight_type();
+    }
+
+    /**
+     * @brief add the edge i -> j
+     *
+     * @param w the weight of the edge
+     */
+    void set(size_type i, size_type j, const weight_type &w = weight_type()){
+      _row(i)[j] = 1;
+      if constexpr (_weighted)
+        _weights.row(i)[j] = w;
+    }
+
+    /**
+     * @brief remove the edge i -> j
+     */
+    void reset(size_type i, size_type j){
+      _row(i)[j] = 0;
+    }
+
+    /**
+     * @brief remove the node at position k, moving the last node in its place
+     *
+     * The row and the column of the last node replace the ones of k,
+     * in O(size) time
+     *
+     * @param k the position of the node to remove
+     * @param size the amount of nodes before the removal
+     */
+    void remove(size_type k, size_type size){
+      const size_type last = size-1;
+      if(k != last){
+        std::copy(_row(last), _row(last)+size, _row(k));
+        for(size_type i=0; i<size; i++)
+          _row(i)[k] = _row(i)[last];
+        if constexpr (_weighted){
+          std::copy(_weights.row(last), _weights.row(last)+size, _weights.row(k));
+          for(size_type i=0; i<size; i++)
+            _weights.row(i)[k] = _weights.row(i)[last];
+        }
+      }
+      std::fill(_row(last), _row(last)+size, 0);
+      for(size_type i=0; i<size; i++)
+        _row(i)[last] = 0;
+    }
+
+    /**
+     * @brief remove many nodes, compacting the matrix in place
+     *
+     * Cells only move towards the start of the block, so they can be
+     * copied in a single forward pass.
+     *
+     * @param remap the new position of each node, or storage_removed.
+     *   The new positions keep the order of the old positions
+     * @param size the amount of nodes before the removal
+     */
+    void compact(const size_type* remap, size_type size){
+      size_type new_size = 0;
+      for(size_type i=0; i<size; i++){
+        if(remap[i] == storage_removed)
+          continue;
+        const int* row = _row(i);
+        int* new_row = _row(remap[i]);
+        for(size_type j=0; j<size; j++)
+          if(remap[j] != storage_removed)
+            new_row[remap[j]] = row[j];
+        if constexpr (_weighted){
+          const W* weights = _weights.row(i);
+          W* new_weights = _weights.row(remap[i]);
+          for(size_type j=0; j<size; j++)
+            if(remap[j] != storage_removed)
+              new_weights[remap[j]] = weights[j];
+        }
+        new_size++;
+      }
+      for(size_type i=0; i<size; i++)
+        std::fill(_row(i) + (i<new_size ? new_size : 0), _row(i)+size, 0);
+    }
+
+    /**
+     * @brief the amount of edges between the first size nodes
+     */
+    std::size_t count(size_type size) const{
+      //the cells outside the graph are 0, the scan can run over whole rows
+      return simd_dispatch().sum(_cells, size * _stride);
+    }
+
+    /**
+     * @brief compute the out and in degree of the first size nodes
+     *
+     * @param size the amount of nodes
+     * @param out filled with the out degree of each node
+     * @param in filled with the in degree of each node
+     */
+    void degrees(size_type size, size_type* out, size_type* in) const{
+      const simd_kernels& simd = simd_dispatch();
+      std::fill(in, in+size, 0);
+      for(size_type i=0; i<size; i++){
+        out[i] = static_cast<size_type>(simd.sum(_row(i), size));
+        simd.accumulate(in, _row(i), size);
+      }
+    }
+
+    /**
+     * @brief the first successor of node i, starting from position j
+     *
+     * @return the position of the successor, or size when there is none
+     */
+    size_type next_out(size_type i, size_type j, size_type size) const{
+      const int* row = _row(i);
+      while(j < size && row[j] == 0)
+        j++;
+      return j;
+    }
+
+    /**
+     * @brief call f(j, weight) for every successor j of node i
+     *
+     * @param size the amount of nodes
+     */
+    template <typename F>
+    void each_out(size_type i, size_type size, F f) const{
+      const int* row = _row(i);
+      for(size_type j=0; j<size; j++)
+        if(row[j] != 0)
+          f(j, weight(i, j));
+    }
+
+    /**
+     * @brief the first predecessor of node j, starting from position i
+     *
+     * @return the position of the predecessor, or size when there is none
+     */
+    size_type next_in(size_type j, size_type i, size_type size) const{
+      while(i < size && _row(i)[j] == 0)
+        i++;
+      return i;
+    }
+
+    /**
+     * @brief no-op, the matrix is already in its read-optimized form
+     */
+    void freeze(size_type){}
+
+    /**
+     * @brief add many edges to an empty storage
+     *
+     * @param from the start positions of the edges
+     * @param to the end positions of the edges
+     * @param weights the weights of the edges, or nullptr for default weights
+     * @param count the amount of edges
+     * @return false when an edge appears twice
+     */
+    bool assign(size_type, const size_type* from, const size_type* to, const weight_type* weights, std::size_t count){
+      for(std::size_t e=0; e<count; e++){
+        if(test(from[e], to[e]))
+          return false;
+        set(from[e], to[e], weights != nullptr ? weights[e] : weight_type());
+      }
+      return true;
+    }
+
+    /**
+     * @brief tag of the storage in the snapshot files
+     *
+     */
+    static constexpr std::uint32_t snapshot_kind = 1;
+
+    /**
+     * @brief the image of the storage can be mapped in place
+     *
+     */
+    static constexpr bool mappable = true;
+
+    /**
+     * @brief the size in bytes of the image of the first size nodes
+     *
+     * The image is the matrix of a storage of capacity size,
+     * followed by the matrix of the weights.
+     */
+    std::size_t image_size(size_type size) const{
+      std::size_t bytes = size * storage_stride_for<int>(size) * sizeof(int);
+      if constexpr (_weighted)
+        bytes += size * storage_stride_for<W>(size) * sizeof(W);
+      return bytes;
+    }
+
+    /**
+     * @brief write the image of the first size nodes
+     */
+    void write_image(std::ostream &out, size_type size) const{
+      static_assert(!_weighted || std::is_trivially_copyable<W>::value, "snapshots need trivially copyable weights");
+      storage_write_rows(out, _cells, _stride, size, size);
+      if constexpr (_weighted)
+        storage_write_rows(out, _weights.row(0), _weights.stride(), size, size);
+    }
+
+    /**
+     * @brief read an image written by write_image
+     *
+     * @pre the storage is empty, and its capacity is size
+     * @return false when the stream ends before the image
+     */
+    bool read_image(std::istream &in, size_type size, std::size_t){
+      static_assert(!_weighted || std::is_trivially_copyable<W>::value, "snapshots need trivially copyable weights");
+      in.read(reinterpret_cast<char*>(_cells), size * _stride * sizeof(int));
+      if constexpr (_weighted)
+        in.read(reinterpret_cast<char*>(_weights.row(0)), size * _weights.stride() * sizeof(W));
+      return static_cast<bool>(in);
+    }
+
+    /**
+     * @brief check the matrix of an image of size nodes
+     *
+     * The weights are not checked, the ones of the missing edges are
+     * never read.
+     *
+     * @return false when a cell is not 0 or 1, or a padding cell is not 0
+     */
+    bool valid_image(size_type size) const{
+      for(size_type i=0; i<size; i++){
+        const int* row = _row(i);
+        for(size_type j=0; j<size; j++)
+          if(row[j] != 0 && row[j] != 1)
+            return false;
+        for(std::size_t j=size; j<_stride; j++)
+          if(row[j] != 0)
+            return false;
+      }
+      return true;
+    }
+
+    /**
+     * @brief use a mapped image of size nodes as the matrix
+     *
+     * The storage takes the mapping, and releases it when destroyed.
+     *
+     * @pre the storage is empty, and its capacity is 0
+     * @param mapping the image, as written by write_image
+     * @param size the amount of nodes of the image
+     */
+    void adopt(storage_mapping &mapping, size_type size){
+      _capacity = size;
+      _stride = storage_stride_for<int>(size);
+      _cells = static_cast<int*>(mapping.data());
+      if constexpr (_weighted)
+        _weights.adopt(reinterpret_cast<W*>(static_cast<char*>(mapping.data()) + size * _stride * sizeof(int)), size);
+      _mapping.swap(mapping);
+    }
+};
+
+
+/**
+ * @brief bit-packed adjacency matrix
+ *
+ * Each row is an array of 64 bit words, where bit j of the row
+ * is set when the edge i -> j exists. Rows are padded to a whole
+ * amount of cache lines. Uses 1/32 of the memory of dense_storage.
+ */
+class bit_storage {
+  public:
+    typedef unsigned int size_type;
+    typedef std::uint64_t word_type;
+    typedef no_weight weight_type;
+
+    /**
+     * @brief the amount of bits in a word
+     *
+     */
+    static constexpr size_type word_bits = 64;
+
+  private:
+    /**
+     * @brief the matrix words
+     *
+     */
+    word_type* _words;
+
+    /**
+     * @brief the amount of rows and columns in the matrix
+     *
+     */
+    size_type _capacity;
+
+    /**
+     * @brief the distance in words between the start of two rows
+     *
+     */
+    std::size_t _stride;
+
+    /**
+     * @brief the mapped snapshot that holds the words, see adopt()
+     *
+     */
+    storage_mapping _mapping;
+
+    /**
+     * @brief pointer to the first word of a row
+     *
+     * @param i the row
+     */
+    word_type* _row(size_type i){
+      return _words + i * _stride;
+    }
+
+    /**
+     * @brief pointer to the first word of a row
+     *
+     * @param i the row
+     */
+    const word_type* _row(size_type i) const{
+      return _words + i * _stride;
+    }
+
+    /**
+     * @brief the amount of words that hold the first size bits of a row
+     */
+    static std::size_t _words_for(size_type size){
+      return (static_cast<std::size_t>(size) + word_bits-1) / word_bits;
+    }
+
+    /**
+     * @brief mask for bit j inside its word
+     */
+    static word_type _mask(size_type j){
+      return word_type(1) << (j % word_bits);
+    }
+
+  public:
+
+    /**
+     * @brief constructor
+     *
+     * @param capacity the amount of nodes the storage can hold
+     * @throw std::bad_alloc
+     */
+    explicit bit_storage(size_type capacity = 0) :
+      _words(nullptr), _capacity(capacity), _stride(storage_stride_for<word_type>(_words_for(capacity))) {
+      _words = storage_new_cells<word_type>(_capacity * _stride);
+    }
+
+    /**
+     * @brief destructor
+     */
+    ~bit_storage(){
+      if(_mapping.data() == nullptr)
+        storage_delete_cells(_words);
+    }
+
+    bit_storage(const bit_storage &other) = delete;
+    bit_storage& operator=(const bit_storage &other) = delete;
+
+    /**
+     * @brief swap the state of the current instance with the given instance
+     *
+     * @param other the instance to swap with
+     */
+    void swap(bit_storage &other){
+      std::swap(_words, other._words);
+      std::swap(_capacity, other._capacity);
+      std::swap(_stride, other._stride);
+      _mapping.swap(other._mapping);
+    }
+
+    /**
+     * @brief copy the edges between the first size nodes of another storage
+     *
+     * @pre the current storage is empty, and its capacity is at least size
+     * @param other the storage to copy
+     * @param size the amount of nodes to copy
+     */
+    void copy_from(const bit_storage &other, size_type size){
+      const std::size_t words = _words_for(size);
+      for(size_type i=0; i<size; i++)
+        std::copy(other._row(i), other._row(i)+words, _row(i));
+    }
+
+    /**
+     * @brief copy the edges between the first size nodes of another storage
+     *
+     * @pre the current storage is empty, and its capacity is at least size
+     * @param other the storage to copy
+     * @param size the amount of nodes to copy
+     */
+    void move_from(bit_storage &other, size_type size){
+      copy_from(other, size);
+    }
+
+    /**
+     * @brief capacity getter
+     */
+    size_type capacity() const{
+      return _capacity;
+    }
+
+    /**
+     * @brief check if the edge i -> j exists
+     */
+    bool test(size_type i, size_type j) const{
+      return (_row(i)[j / word_bits] & _mask(j)) != 0;
+    }
+
+    /**
+     * @brief the weight of the edge i -> j, the storage has no weights
+     */
+    weight_type weight(size_type, size_type) const{
+      return weight_type();
+    }
+
+    /**
+     * @brief add the edge i -> j
+     */
+    void set(size_type i, size_type j, const weight_type & = weight_type()){
+      _row(i)[j / word_bits] |= _mask(j);
+    }
+
+    /**
+     * @brief remove the edge i -> j
+     */
+    void reset(size_type i, size_type j){
+      _row(i)[j / word_bits] &= ~_mask(j);
+    }
+
+    /**
+     * @brief remove the node at position k, moving the last node in its place
+     *
+     * The row and the column of the last node replace the ones of k,
+     * in O(size) time
+     *
+     * @param k the position of the node to remove
+     * @param size the amount of nodes before the removal
+     */
+    void remove(size_type k, size_type size){
+      const size_type last = size-1;
+      const std::size_t words = _words_for(size);
+      if(k != last){
+        std::copy(_row(last), _row(last)+words, _row(k));
+        for(size_type i=0; i<size; i++){
+          if(test(i, last))
+            set(i, k);
+          else
+            reset(i, k);
+        }
+      }
+      std::fill(_row(last), _row(last)+words, word_type(0));
+      for(size_type i=0; i<size; i++)
+        reset(i, last);
+    }
+
+    /**
+     * @brief remove many nodes, compacting the matrix in place
+     *
+     * Bits only move towards the start of the block: each word is read
+     * before any bit is written into it.
+     *
+     * @param remap the new position of each node, or storage_removed.
+     *   The new positions keep the order of the old positions
+     * @param size the amount of nodes before the removal
+     */
+    void compact(const size_type* remap, size_type size){
+      const std::size_t words = _words_for(size);
+      size_type new_size = 0;
+      for(size_type i=0; i<size; i++){
+        if(remap[i] == storage_removed)
+          continue;
+        word_type* row = _row(i);
+        word_type* new_row = _row(remap[i]);
+        //the old content of a different destination row was already moved
+        if(new_row != row)
+          std::fill(new_row, new_row+words, word_type(0));
+        for(std::size_t w=0; w<words; w++){
+          word_type bits = row[w];
+          if(new_row == row)
+            row[w] = 0;
+          while(bits != 0){
+            const size_type j = static_cast<size_type>(w * word_bits + __builtin_ctzll(bits));
+            bits &= bits - 1;
+            if(remap[j] != storage_removed)
+              set(remap[i], remap[j]);
+          }
+        }
+        new_size++;
+      }
+      for(size_type i=new_size; i<size; i++)
+        std::fill(_row(i), _row(i)+words, word_type(0));
+    }
+
+    /**
+     * @brief the amount of edges between the first size nodes
+     */
+    std::size_t count(size_type size) const{
+      //the bits outside the graph are 0, the scan can run over whole rows
+      return simd_dispatch().popcount(_words, size * _stride);
+    }
+
+    /**
+     * @brief compute the out and in degree of the first size nodes
+     *
+     * @param size the amount of nodes
+     * @param out filled with the out degree of each node
+     * @param in filled with the in degree of each node
+     */
+    void degrees(size_type size, size_type* out, size_type* in) const{
+      const simd_kernels& simd = simd_dispatch();
+      const std::size_t words = _words_for(size);
+      std::fill(in, in+size, 0);
+      for(size_type i=0; i<size; i++){
+        const word_type* row = _row(i);
+        out[i] = static_cast<size_type>(simd.popcount(row, words));
+        for(std::size_t w=0; w<words; w++){
+          word_type bits = row[w];
+          while(bits != 0){
+            in[w * word_bits + __builtin_ctzll(bits)]++;
+            bits &= bits - 1;
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief the first successor of node i, starting from position j
+     *
+     * Empty words are skipped with a single comparison
+     *
+     * @return the position of the successor, or size when there is none
+     */
+    size_type next_out(size_type i, size_type j, size_type size) const{
+      if(j >= size)
+        return size;
+      const word_type* row = _row(i);
+      const std::size_t words = _words_for(size);
+      std::size_t w = j / word_bits;
+      word_type bits = row[w] & ~(_mask(j) - 1);
+      while(bits == 0){
+        if(++w >= words)
+          return size;
+        bits = row[w];
+      }
+      return static_cast<size_type>(w * word_bits + __builtin_ctzll(bits));
+    }
+
+    /**
+     * @brief call f(j, weight) for every successor j of node i
+     *
+     * @param size the amount of nodes
+     */
+    template <typename F>
+    void each_out(size_type i, size_type size, F f) const{
+      const word_type* row = _row(i);
+      const std::size_t words = _words_for(size);
+      for(std::size_t w=0; w<words; w++)
+        for(word_type bits = row[w]; bits != 0; bits &= bits - 1)
+          f(static_cast<size_type>(w * word_bits + __builtin_ctzll(bits)), weight_type());
+    }
+
+    /**
+     * @brief the first predecessor of node j, starting from position i
+     *
+     * @return the position of the predecessor, or size when there is none
+     */
+    size_type next_in(size_type j, size_type i, size_type size) const{
+      const std::size_t w = j / word_bits;
+      const word_type mask = _mask(j);
+      while(i < size && (_row(i)[w] & mask) == 0)
+        i++;
+      return i;
+    }
+
+    /**
+     * @brief no-op, the matrix is already in its read-optimized form
+     */
+    void freeze(size_type){}
+
+    /**
+     * @brief add many edges to an empty storage
+     *
+     * @param from the start positions of the edges
+     * @param to the end positions of the edges
+     * @param weights the weights of the edges, or nullptr for default weights
+     * @param count the amount of edges
+     * @return false when an edge appears twice
+     */
+    bool assign(size_type, const size_type* from, const size_type* to, const weight_type* weights, std::size_t count){
+      for(std::size_t e=0; e<count; e++){
+        if(test(from[e], to[e]))
+          return false;
+        set(from[e], to[e], weights != nullptr ? weights[e] : weight_type());
+      }
+      return true;
+    }
+
+    /**
+     * @brief tag of the storage in the snapshot files
+     *
+     */
+    static constexpr std::uint32_t snapshot_kind = 2;
+
+    /**
+     * @brief the image of the storage can be mapped in place
+     *
+     */
+    static constexpr bool mappable = true;
+
+    /**
+     * @brief the size in bytes of the image of the first size nodes,
+     *   the matrix of a storage of capacity size
+     */
+    std::size_t image_size(size_type size) const{
+      return size * storage_stride_for<word_type>(_words_for(size)) * sizeof(word_type);
+    }
+
+    /**
+     * @brief write the image of the first size nodes
+     */
+    void write_image(std::ostream &out, size_type size) const{
+      storage_write_rows(out, _words, _stride, size, _words_for(size));
+    }
+
+    /**
+     * @brief read an image written by write_image
+     *
+     * @pre the storage is empty, and its capacity is size
+     * @return false when the stream ends before the image
+     */
+    bool read_image(std::istream &in, size_type size, std::size_t){
+      in.read(reinterpret_cast<char*>(_words), size * _stride * sizeof(word_type));
+      return static_cast<bool>(in);
+    }
+
+    /**
+     * @brief check the matrix of an image of size nodes
+     *
+     * @return false when a bit at or past size is set, in the last word
+     *   of a row or in a padding word
+     */
+    bool valid_image(size_type size) const{
+      const std::size_t words = _words_for(size);
+      const word_type tail = size % word_bits == 0 ? 0 : ~(_mask(size) - 1);
+      for(size_type i=0; i<size; i++){
+        const word_type* row = _row(i);
+        if((row[words-1] & tail) != 0)
+          return false;
+        for(std::size_t w=words; w<_stride; w++)
+          if(row[w] != 0)
+            return false;
+      }
+      return true;
+    }
+
+    /**
+     * @brief use a mapped image of size nodes as the matrix
+     *
+     * The storage takes the mapping, and releases it when destroyed.
+     *
+     * @pre the storage is empty, and its capacity is 0
+     * @param mapping the image, as written by write_image
+     * @param size the amount of nodes of the image
+     */
+    void adopt(storage_mapping &mapping, size_type size){
+      _capacity = size;
+      _stride = storage_stride_for<word_type>(_words_for(size));
+      _words = static_cast<word_type*>(mapping.data());
+      _mapping.swap(mapping);
+    }
+};
+
+
+/**
+ * @brief element of the adjacency lists of a weighted sparse_storage
+ *
+ */
+template <typename W>
+struct storage_entry {
+  unsigned int to;
+  W weight;
+};
+
+/**
+ * @brief the position of an element of the adjacency lists
+ */
+inline unsigned int storage_key(unsigned int e){
+  return e;
+}
+
+template <typename W>
+unsigned int storage_key(const storage_entry<W> &e){
+  return e.to;
+}
+
+/**
+ * @brief change the position of an element of the adjacency lists
+ */
+inline void storage_rekey(unsigned int &e, unsigned int j){
+  e = j;
+}
+
+template <typename W>
+void storage_rekey(storage_entry<W> &e, unsigned int j){
+  e.to = j;
+}
+
+/**
+ * @brief adjacency lists in one direction, used by sparse_storage
+ *
+ * The elements of the lists are positions, or storage_entry when
+ * the positions carry a weight. The lists are sorted by position.
+ *
+ * The lists have two forms:
+ *  - mutable: one sorted vector of elements per node
+ *  - frozen: a single CSR block, where the list of node i is
+ *    _targets[_first[i] .. _last[i]). Nodes past the frozen rows
+ *    have empty lists. Removals shrink the lists in place, and can
+ *    leave unused space in the block until the next freeze.
+ *
+ * @tparam Entry the element type, unsigned int or storage_entry
+ */
+template <typename Entry = unsigned int>
+class sparse_lists {
+  public:
+    typedef unsigned int size_type;
+
+  private:
+    /**
+     * @brief the sorted lists, used when not frozen
+     *
+     */
+    std::vector<std::vector<Entry> > _lists;
+
+    /**
+     * @brief start of the list of each node in _targets, used when frozen
+     *
+     */
+    std::vector<std::size_t> _first;
+
+    /**
+     * @brief end of the list of each node in _targets, used when frozen
+     *
+     */
+    std::vector<std::size_t> _last;
+
+    /**
+     * @brief the concatenated lists, used when frozen
+     *
+     */
+    std::vector<Entry> _targets;
+
+    /**
+     * @brief true when the lists are in the CSR form
+     *
+     */
+    bool _frozen;
+
+    /**
+     * @brief the amount of nodes in the CSR form
+     *
+     */
+    size_type _frozen_rows;
+
+    /**
+     * @brief pointer to the first element of the list of node i
+     */
+    Entry* _begin(size_type i){
+      if(!_frozen)
+        return _lists[i].data();
+      return i < _frozen_rows ? _targets.data() + _first[i] : nullptr;
+    }
+
+    /**
+     * @brief pointer past the last element of the list of node i
+     */
+    Entry* _end(size_type i){
+      if(!_frozen)
+        return _lists[i].data() + _lists[i].size();
+      return i < _frozen_rows ? _targets.data() + _last[i] : nullptr;
+    }
+
+    /**
+     * @brief order of an element and a position, for the binary searches
+     */
+    static bool _before(const Entry &e, size_type j){
+      return storage_key(e) < j;
+    }
+
+    /**
+     * @brief order of two elements
+     */
+    static bool _by_key(const Entry &a, const Entry &b){
+      return storage_key(a) < storage_key(b);
+    }
+
+    /**
+     * @brief build the CSR form of the first size lists
+     *
+     * @throw std::bad_alloc
+     */
+    void _pack(size_type size){
+      std::vector<std::size_t> first(size), last(size);
+      std::size_t elements = 0;
+      for(size_type i=0; i<size; i++){
+        first[i] = elements;
+        elements += length(i);
+        last[i] = elements;
+      }
+      std::vector<Entry> targets(elements);
+      for(size_type i=0; i<size; i++)
+        std::copy(begin(i), end(i), targets.begin() + first[i]);
+
+      //commit
+      std::vector<std::vector<Entry> > empty(_lists.size());
+      _lists.swap(empty);
+      _first.swap(first);
+      _last.swap(last);
+      _targets.swap(targets);
+      _frozen_rows = size;
+      _frozen = true;
+    }
+
+  public:
+
+    /**
+     * @brief constructor
+     *
+     * @param capacity the amount of nodes the lists can hold
+     * @throw std::bad_alloc
+     */
+    explicit sparse_lists(size_type capacity = 0) :
+      _lists(capacity), _frozen(false), _frozen_rows(0) {}
+
+    /**
+     * @brief swap the state of the current instance with the given instance
+     *
+     * @param other the instance to swap with
+     */
+    void swap(sparse_lists &other){
+      _lists.swap(other._lists);
+      _first.swap(other._first);
+      _last.swap(other._last);
+      _targets.swap(other._targets);
+      std::swap(_frozen, other._frozen);
+      std::swap(_frozen_rows, other._frozen_rows);
+    }
+
+    /**
+     * @brief copy the lists of the first size nodes of other
+     *
+     * @pre the current lists are empty, with room for size nodes
+     * @throw std::bad_alloc
+     */
+    void copy_from(const sparse_lists &other, size_type size){
+      if(other._frozen){
+        std::vector<std::size_t> first(other._first), last(other._last);
+        std::vector<Entry> targets(other._targets);
+        _first.swap(first);
+        _last.swap(last);
+        _targets.swap(targets);
+        //the rows past size are not copied, the new lists may have no room for them
+        _frozen_rows = std::min(other._frozen_rows, size);
+        _frozen = true;
+        return;
+      }
+      std::vector<std::vector<Entry> > lists(_lists.size());
+      for(size_type i=0; i<size; i++)
+        lists[i] = other._lists[i];
+      _lists.swap(lists);
+    }
+
+    /**
+     * @brief take the lists of the first size nodes of other
+     *
+     * @pre the current lists are empty, with room for size nodes
+     */
+    void move_from(sparse_lists &other, size_type size){
+      if(other._frozen){
+        _first.swap(other._first);
+        _last.swap(other._last);
+        _targets.swap(other._targets);
+        _frozen_rows = std::min(other._frozen_rows, size);
+        _frozen = true;
+        return;
+      }
+      for(size_type i=0; i<size; i++)
+        _lists[i].swap(other._lists[i]);
+    }
+
+    /**
+     * @brief pointer to the first element of the list of node i
+     */
+    const Entry* begin(size_type i) const{
+      if(!_frozen)
+        return _lists[i].data();
+      return i < _frozen_rows ? _targets.data() + _first[i] : nullptr;
+    }
+
+    /**
+     * @brief pointer past the last element of the list of node i
+     */
+    const Entry* end(size_type i) const{
+      if(!_frozen)
+        return _lists[i].data() + _lists[i].size();
+      return i < _frozen_rows ? _targets.data() + _last[i] : nullptr;
+    }
+
+    /**
+     * @brief the length of the list of node i
+     */
+    std::size_t length(size_type i) const{
+      return end(i) - begin(i);
+    }
+
+    /**
+     * @brief check if j is in the list of node i
+     */
+    bool contains(size_type i, size_type j) const{
+      return find(i, j) != nullptr;
+    }
+
+    /**
+     * @brief the first element of the list of node i not before position j
+     */
+    const Entry* lower_bound(size_type i, size_type j) const{
+      return std::lower_bound(begin(i), end(i), j, _before);
+    }
+
+    /**
+     * @brief the element of position j in the list of node i
+     *
+     * @return the element, or nullptr when j is not in the list
+     */
+    const Entry* find(size_type i, size_type j) const{
+      const Entry* pos = lower_bound(i, j);
+      return (pos != end(i) && storage_key(*pos) == j) ? pos : nullptr;
+    }
+
+    /**
+     * @brief insert an element in the list of node i
+     *
+     * thaws the lists when frozen
+     *
+     * @pre the position of the element is not in the list
+     * @throw std::bad_alloc
+     */
+    void insert(size_type i, const Entry &e){
+      if(_frozen)
+        thaw();
+      std::vector<Entry> &list = _lists[i];
+      list.insert(std::lower_bound(list.begin(), list.end(), storage_key(e), _before), e);
+    }
+
+    /**
+     * @brief remove j from the list of node i
+     *
+     * In the frozen form the list shrinks in place
+     *
+     * @pre j is in the list
+     */
+    void erase(size_type i, size_type j){
+      if(!_frozen){
+        std::vector<Entry> &list = _lists[i];
+        list.erase(std::lower_bound(list.begin(), list.end(), j, _before));
+        return;
+      }
+      Entry* pos = std::lower_bound(_begin(i), _end(i), j, _before);
+      std::copy(pos+1, _end(i), pos);
+      _last[i]--;
+    }
+
+    /**
+     * @brief replace v with w in the list of node i, keeping it sorted
+     *
+     * @pre v is in the list, w is not
+     */
+    void replace(size_type i, size_type v, size_type w){
+      Entry* first = _begin(i);
+      Entry* last = _end(i);
+      Entry* pos = std::lower_bound(first, last, v, _before);
+      Entry* target = std::lower_bound(first, last, w, _before);
+      if(target > pos){
+        std::rotate(pos, pos+1, target);
+        storage_rekey(*(target-1), w);
+      }
+      else{
+        std::rotate(target, pos, pos+1);
+        storage_rekey(*target, w);
+      }
+    }
+
+    /**
+     * @brief empty the list of node i
+     */
+    void clear(size_type i){
+      if(!_frozen)
+        _lists[i].clear();
+      else if(i < _frozen_rows)
+        _last[i] = _first[i];
+    }
+
+    /**
+     * @brief move the list of node from to node to
+     *
+     * @pre the list of node to is empty
+     */
+    void move(size_type from, size_type to){
+      if(!_frozen){
+        _lists[to].swap(_lists[from]);
+        return;
+      }
+      if(to < _frozen_rows){
+        _first[to] = from < _frozen_rows ? _first[from] : 0;
+        _last[to] = from < _frozen_rows ? _last[from] : 0;
+      }
+      clear(from);
+    }
+
+    /**
+     * @brief remove many nodes, renumbering the others
+     *
+     * @param remap the new position of each node, or storage_removed.
+     *   The new positions keep the order of the old positions,
+     *   so the lists stay sorted
+     * @param size the amount of nodes before the removal
+     * @return the amount of elements left in the lists
+     */
+    std::size_t compact(const size_type* remap, size_type size){
+      //lists only move towards the start, to positions that were already processed
+      std::size_t elements = 0;
+      size_type new_size = 0;
+      for(size_type i=0; i<size; i++){
+        if(remap[i] == storage_removed){
+          clear(i);
+          continue;
+        }
+        Entry* first = _begin(i);
+        Entry* last = _end(i);
+        Entry* write = first;
+        for(Entry* p=first; p<last; p++)
+          if(remap[storage_key(*p)] != storage_removed){
+            *write = *p;
+            storage_rekey(*(write++), remap[storage_key(*p)]);
+          }
+        if(!_frozen)
+          _lists[i].resize(write - first);
+        else if(i < _frozen_rows)
+          _last[i] = _first[i] + (write - first);
+        elements += write - first;
+        if(remap[i] != i)
+          move(i, remap[i]);
+        new_size++;
+      }
+      for(size_type i=new_size; i<size; i++)
+        clear(i);
+      truncate(new_size);
+      return elements;
+    }
+
+    /**
+     * @brief drop the lists of the nodes from size on
+     *
+     * @pre the lists of those nodes are empty
+     * @post the frozen rows are at most size
+     */
+    void truncate(size_type size){
+      if(_frozen && _frozen_rows > size)
+        _frozen_rows = size;
+    }
+
+    /**
+     * @brief compact the lists of the first size nodes in the CSR form
+     *
+     * When the lists are already frozen, the unused space left
+     * by removals is released.
+     *
+     * @throw std::bad_alloc
+     */
+    void freeze(size_type size){
+      if(_frozen && _frozen_rows == size && (size == 0 || _last[size-1] == _targets.size())){
+        bool packed = (size == 0 || _first[0] == 0);
+        for(size_type i=1; i<size && packed; i++)
+          packed = _first[i] == _last[i-1];
+        if(packed)
+          return;
+      }
+      _pack(size);
+    }
+
+    /**
+     * @brief build the CSR form from a list of pairs
+     *
+     * The pairs are bucketed by row with a counting sort,
+     * then each row is sorted.
+     *
+     * @pre the lists are empty
+     * @param size the amount of nodes
+     * @param rows the node owning the list, for each pair
+     * @param cols the element to add to the list, for each pair
+     * @param count the amount of pairs
+     * @throw std::bad_alloc
+     * @return false when a position appears twice in a list
+     */
+    bool assign(size_type size, const size_type* rows, const Entry* cols, std::size_t count){
+      std::vector<std::size_t> first(size, 0), last(size, 0);
+      for(std::size_t e=0; e<count; e++)
+        last[rows[e]]++;
+      std::size_t elements = 0;
+      for(size_type i=0; i<size; i++){
+        first[i] = elements;
+        elements += last[i];
+        last[i] = first[i];
+      }
+      std::vector<Entry> targets(count);
+      for(std::size_t e=0; e<count; e++)
+        targets[last[rows[e]]++] = cols[e];
+      for(size_type i=0; i<size; i++){
+        typename std::vector<Entry>::iterator row_begin = targets.begin() + first[i];
+        typename std::vector<Entry>::iterator row_end = targets.begin() + last[i];
+        std::sort(row_begin, row_end, _by_key);
+        for(typename std::vector<Entry>::iterator e = row_begin; e != row_end && e+1 != row_end; ++e)
+          if(storage_key(*e) == storage_key(*(e+1)))
+            return false;
+      }
+
+      //commit
+      _first.swap(first);
+      _last.swap(last);
+      _targets.swap(targets);
+      _frozen_rows = size;
+      _frozen = true;
+      return true;
+    }
+
+    /**
+     * @brief move the lists back to the mutable form
+     *
+     * @throw std::bad_alloc
+     */
+    void thaw(){
+      if(!_frozen)
+        return;
+      std::vector<std::vector<Entry> > lists(_lists.size());
+      const size_type rows = std::min<std::size_t>(_frozen_rows, lists.size());
+      for(size_type i=0; i<rows; i++)
+        lists[i].assign(begin(i), end(i));
+
+      //commit
+      _lists.swap(lists);
+      std::vector<std::size_t>().swap(_first);
+      std::vector<std::size_t>().swap(_last);
+      std::vector<Entry>().swap(_targets);
+      _frozen_rows = 0;
+      _frozen = false;
+    }
+};
+
+
+/**
+ * @brief sparse adjacency lists
+ *
+ * Every node has a sorted list of successors and a sorted list of
+ * predecessors. Memory and scans scale with the amount of edges
+ * instead of the square of the amount of nodes.
+ * After freeze() the lists are packed in CSR form, which is faster
+ * to scan; the first insertion moves them back to the mutable form.
+ * With a weight type, the weight of an edge is kept next to the
+ * successor in the list of its start node.
+ *
+ * @tparam W the weight type, or no_weight
+ */
+template <typename W = no_weight>
+class sparse_storage {
+  public:
+    typedef unsigned int size_type;
+    typedef W weight_type;
+
+  private:
+    static constexpr bool _weighted = !std::is_same<W, no_weight>::value;
+
+    /**
+     * @brief element of the lists of successors
+     *
+     */
+    typedef typename std::conditional<_weighted, storage_entry<W>, size_type>::type _entry;
+
+    /**
+     * @brief the successors of each node
+     *
+     */
+    sparse_lists<_entry> _out;
+
+    /**
+     * @brief the predecessors of each node
+     *
+     */
+    sparse_lists<size_type> _in;
+
+    /**
+     * @brief the amount of edges
+     *
+     */
+    std::size_t _edges;
+
+    /**
+     * @brief the amount of nodes the storage can hold
+     *
+     */
+    size_type _capacity;
+
+  public:
+
+    /**
+     * @brief constructor
+     *
+     * @param capacity the amount of nodes the storage can hold
+     * @throw std::bad_alloc
+     */
+    explicit sparse_storage(size_type capacity = 0) :
+      _out(capacity), _in(capacity), _edges(0), _capacity(capacity) {}
+
+    sparse_storage(const sparse_storage &other) = delete;
+    sparse_storage& operator=(const sparse_storage &other) = delete;
+
+    /**
+     * @brief swap the state of the current instance with the given instance
+     *
+     * @param other the instance to swap with
+     */
+    void swap(sparse_storage &other){
+      _out.swap(other._out);
+      _in.swap(other._in);
+      std::swap(_edges, other._edges);
+      std::swap(_capacity, other._capacity);
+    }
+
+    /**
+     * @brief copy the edges between the first size nodes of another storage
+     *
+     * @pre the current storage is empty, and its capacity is at least size
+     * @param other the storage to copy
+     * @param size the amount of nodes to copy
+     * @throw std::bad_alloc
+     */
+    void copy_from(const sparse_storage &other, size_type size){
+      sparse_lists<_entry> out(_capacity);
+      sparse_lists<size_type> in(_capacity);
+      out.copy_from(other._out, size);
+      in.copy_from(other._in, size);
+      _out.swap(out);
+      _in.swap(in);
+      _edges = other._edges;
+    }
+
+    /**
+     * @brief take the edges between the first size nodes of another storage
+     *
+     * @pre the current storage is empty, and its capacity is at least size
+     * @param other the storage to take the edges from
+     * @param size the amount of nodes to move
+     */
+    void move_from(sparse_storage &other, size_type size){
+      _out.move_from(other._out, size);
+      _in.move_from(other._in, size);
+      _edges = other._edges;
+    }
+
+    /**
+     * @brief capacity getter
+     */
+    size_type capacity() const{
+      return _capacity;
+    }
+
+    /**
+     * @brief check if the edge i -> j exists
+     */
+    bool test(size_type i, size_type j) const{
+      return _out.contains(i, j);
+    }
+
+    /**
+     * @brief the weight of the edge i -> j
+     *
+     * @pre the edge exists
+     */
+    weight_type weight(size_type i, size_type j) const{
+      if constexpr (_weighted)
+        return _out.find(i, j)->weight;
+      else
+        return weight_type();
+    }
+
+    /**
+     * @brief add the edge i -> j
+     *
+     * @pre the edge does not exist
+     * @param w the weight of the edge
+     * @throw std::bad_alloc
+     */
+    void set(size_type i, size_type j, const weight_type &w = weight_type()){
+      if constexpr (_weighted)
+        _out.insert(i, _entry{j, w});
+      else
+        _out.insert(i, j);
+      try{
+        _in.insert(j, i);
+      }
+      catch(...){
+        _out.erase(i, j);
+        throw;
+      }
+      _edges++;
+    }
+
+    /**
+     * @brief remove the edge i -> j
+     *
+     * @pre the edge exists
+     */
+    void reset(size_type i, size_type j){
+      _out.erase(i, j);
+      _in.erase(j, i);
+      _edges--;
+    }
+
+    /**
+     * @brief remove the node at position k, moving the last node in its place
+     *
+     * Only the lists of k, of the last node and of their neighbors
+     * are touched. Works in place on both forms.
+     *
+     * @param k the position of the node to remove
+     * @param size the amount of nodes before the removal
+     */
+    void remove(size_type k, size_type size){
+      const size_type last = size-1;
+
+      //drop the edges of k
+      const bool loop = test(k, k);
+      _edges -= _out.length(k) + _in.length(k) - (loop ? 1 : 0);
+      for(const _entry* s = _out.begin(k); s != _out.end(k); s++)
+        if(storage_key(*s) != k)
+          _in.erase(storage_key(*s), k);
+      for(const size_type* p = _in.begin(k); p != _in.end(k); p++)
+        if(*p != k)
+          _out.erase(*p, k);
+      _out.clear(k);
+      _in.clear(k);
+      if(k == last){
+        _out.truncate(last);
+        _in.truncate(last);
+        return;
+      }
+
+      //renumber the last node to k
+      for(const _entry* s = _out.begin(last); s != _out.end(last); s++)
+        if(storage_key(*s) != last)
+          _in.replace(storage_key(*s), last, k);
+      for(const size_type* p = _in.begin(last); p != _in.end(last); p++)
+        if(*p != last)
+          _out.replace(*p, last, k);
+      if(_out.contains(last, last)){
+        _out.replace(last, last, k);
+        _in.replace(last, last, k);
+      }
+      _out.move(last, k);
+      _in.move(last, k);
+      _out.truncate(last);
+      _in.truncate(last);
+    }
+
+    /**
+     * @brief remove many nodes, renumbering the others
+     *
+     * @param remap the new position of each node, or storage_removed.
+     *   The new positions keep the order of the old positions
+     * @param size the amount of nodes before the removal
+     */
+    void compact(const size_type* remap, size_type size){
+      _edges = _out.compact(remap, size);
+      _in.compact(remap, size);
+    }
+
+    /**
+     * @brief the amount of edges between the first size nodes
+     */
+    std::size_t count(size_type) const{
+      return _edges;
+    }
+
+    /**
+     * @brief compute the out and in degree of the first size nodes
+     *
+     * @param size the amount of nodes
+     * @param out filled with the out degree of each node
+     * @param in filled with the in degree of each node
+     */
+    void degrees(size_type size, size_type* out, size_type* in) const{
+      for(size_type i=0; i<size; i++){
+        out[i] = static_cast<size_type>(_out.length(i));
+        in[i] = static_cast<size_type>(_in.length(i));
+      }
+    }
+
+    /**
+     * @brief the first successor of node i, starting from position j
+     *
+     * @return the position of the successor, or size when there is none
+     */
+    size_type next_out(size_type i, size_type j, size_type size) const{
+      const _entry* it = _out.lower_bound(i, j);
+      return it == _out.end(i) ? size : storage_key(*it);
+    }
+
+    /**
+     * @brief call f(j, weight) for every successor j of node i
+     *
+     * A single walk of the list of i, without any search.
+     */
+    template <typename F>
+    void each_out(size_type i, size_type, F f) const{
+      const _entry* end = _out.end(i);
+      for(const _entry* s = _out.begin(i); s != end; s++)
+        if constexpr (_weighted)
+          f(s->to, s->weight);
+        else
+          f(*s, weight_type());
+    }
+
+    /**
+     * @brief the first predecessor of node j, starting from position i
+     *
+     * @return the position of the predecessor, or size when there is none
+     */
+    size_type next_in(size_type j, size_type i, size_type size) const{
+      const size_type* it = _in.lower_bound(j, i);
+      return it == _in.end(j) ? size : *it;
+    }
+
+    /**
+     * @brief compact the edges in the CSR form
+     *
+     * @param size the amount of nodes
+     * @throw std::bad_alloc
+     */
+    void freeze(size_type size){
+      //each direction can be frozen on its own,
+      //an exception between the two calls leaves a valid storage
+      _out.freeze(size);
+      _in.freeze(size);
+    }
+
+    /**
+     * @brief add many edges to an empty storage
+     *
+     * The edges are written directly in the frozen CSR form
+     *
+     * @param size the amount of nodes
+     * @param from the start positions of the edges
+     * @param to the end positions of the edges
+     * @param weights the weights of the edges, or nullptr for default weights
+     * @param count the amount of edges
+     * @throw std::bad_alloc
+     * @return false when an edge appears twice
+     */
+    bool assign(size_type size, const size_type* from, const size_type* to, const weight_type* weights, std::size_t count){
+      if constexpr (_weighted){
+        std::vector<_entry> entries(count);
+        for(std::size_t e=0; e<count; e++)
+          entries[e] = _entry{to[e], weights != nullptr ? weights[e] : weight_type()};
+        if(!_out.assign(size, from, entries.data(), count))
+          return false;
+      }
+      else if(!_out.assign(size, from, to, count))
+        return false;
+      _in.assign(size, to, from, count);
+      _edges = count;
+      return true;
+    }
+
+    /**
+     * @brief tag of the storage in the snapshot files
+     *
+     */
+    static constexpr std::uint32_t snapshot_kind = 3;
+
+    /**
+     * @brief the image is an edge list, it is always read
+     *
+     */
+    static constexpr bool mappable = false;
+
+    /**
+     * @brief the size in bytes of the image of the first size nodes
+     *
+     * The image is the start positions of all the edges, then the end
+     * positions, then the weights.
+     */
+    std::size_t image_size(size_type) const{
+      std::size_t bytes = _edges * 2 * sizeof(size_type);
+      if constexpr (_weighted)
+        bytes += _edges * sizeof(W);
+      return bytes;
+    }
+
+    /**
+     * @brief write the image of the first size nodes
+     */
+    void write_image(std::ostream &out, size_type size) const{
+      static_assert(!_weighted || std::is_trivially_copyable<W>::value, "snapshots need trivially copyable weights");
+      for(size_type i=0; i<size; i++)
+        for(std::size_t e=0; e<_out.length(i); e++)
+          out.write(reinterpret_cast<const char*>(&i), sizeof(size_type));
+      for(size_type i=0; i<size; i++)
+        each_out(i, size, [&](size_type j, const weight_type &){
+          out.write(reinterpret_cast<const char*>(&j), sizeof(size_type));
+        });
+      if constexpr (_weighted)
+        for(size_type i=0; i<size; i++)
+          each_out(i, size, [&](size_type, const weight_type &w){
+            out.write(reinterpret_cast<const char*>(&w), sizeof(W));
+          });
+    }
+
+    /**
+     * @brief read an image written by write_image, in the frozen form
+     *
+     * @pre the storage is empty
+     * @param edges the amount of edges of the image
+     * @throw std::bad_alloc
+     * @return false when the stream ends before the image, or the image is not valid
+     */
+    bool read_image(std::istream &in, size_type size, std::size_t edges){
+      static_assert(!_weighted || std::is_trivially_copyable<W>::value, "snapshots need trivially copyable weights");
+      std::vector<size_type> from(edges), to(edges);
+      std::vector<weight_type> weights(_weighted ? edges : 0);
+      in.read(reinterpret_cast<char*>(from.data()), edges * sizeof(size_type));
+      in.read(reinterpret_cast<char*>(to.data()), edges * sizeof(size_type));
+      if constexpr (_weighted)
+        in.read(reinterpret_cast<char*>(weights.data()), edges * sizeof(W));
+      if(!in)
+        return false;
+      for(std::size_t e=0; e<edges; e++)
+        if(from[e] >= size || to[e] >= size)
+          return false;
+      return assign(size, from.data(), to.data(), _weighted ? weights.data() : nullptr, edges);
+    }
+
+    /**
+     * @brief always true, read_image already checks the edges
+     */
+    bool valid_image(size_type) const{
+      return true;
+    }
+};
+
+#endif